@@ -0,0 +1,236 @@
+#ifndef PerfCounters_Included
+#define PerfCounters_Included
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Hardware performance counters, read through Linux's perf_event_open:
+ * cycles, instructions, L1 data cache misses, last-level cache misses,
+ * branch mispredictions and data TLB misses. They say why one data
+ * structure beats another: fewer cache misses, or fewer mispredicted
+ * branches.
+ *
+ * Nothing is counted until enable() is called, which run-tests does when
+ * given --counters. A counter the machine or the kernel won't provide
+ * (other systems, most virtual machines, perf_event_paranoid above 2) is
+ * left out and reads as NaN. Only user-space events of this thread are
+ * counted.
+ */
+class PerfCounters {
+public:
+  enum Event { kCycles, kInstructions, kL1DMisses, kLLCMisses, kBranchMisses, kDTLBMisses, kNumEvents };
+
+  /* One count per event, NaN where the event isn't available. */
+  typedef std::array<double, kNumEvents> Counts;
+
+  /* The counters the timing functions use. */
+  static PerfCounters& current() {
+    static PerfCounters counters;
+    return counters;
+  }
+
+  ~PerfCounters() {
+    for (int fd : fds) {
+#if defined(__linux__)
+      if (fd >= 0) close(fd);
+#endif
+    }
+  }
+
+  static const char* name(Event event) {
+    static const char* const names[kNumEvents] = {
+      "cycles", "instructions", "L1d misses", "LLC misses", "branch misses", "dTLB misses"
+    };
+    return names[event];
+  }
+
+  /**
+   * Opens all counters that can be opened. Returns whether there was at
+   * least one; if not, reason() says why.
+   */
+  bool enable() {
+#if defined(__linux__)
+    static const std::pair<uint32_t, uint64_t> kEvents[kNumEvents] = {
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_L1D)},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+      {PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_DTLB)},
+    };
+    int firstError = 0;
+    for (int event = 0; event < kNumEvents; event++) {
+      if (fds[event] >= 0) continue;
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = kEvents[event].first;
+      attr.config = kEvents[event].second;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      // Scale for the time a counter was multiplexed out.
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      fds[event] = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+      if (fds[event] < 0 && firstError == 0) firstError = errno;
+    }
+    if (!enabled()) why = std::string("perf_event_open: ") + std::strerror(firstError);
+#else
+    why = "perf_event_open is Linux-only";
+#endif
+    return enabled();
+  }
+
+  bool enabled() const {
+    for (int fd : fds) {
+      if (fd >= 0) return true;
+    }
+    return false;
+  }
+
+  const std::string& reason() const {
+    return why;
+  }
+
+  /**
+   * Returns what the counters count while f runs. Starting and stopping
+   * them are system calls, so f should be a whole loop of operations.
+   */
+  template <typename F>
+  Counts measure(F f) {
+    control(Request::Start);
+    f();
+    control(Request::Stop);
+
+    Counts counts;
+    counts.fill(std::numeric_limits<double>::quiet_NaN());
+#if defined(__linux__)
+    for (int event = 0; event < kNumEvents; event++) {
+      uint64_t values[3]; // value, time enabled, time running
+      if (fds[event] < 0 || read(fds[event], values, sizeof(values)) != ssize_t(sizeof(values))) continue;
+      if (values[2] == 0) continue; // never got onto the hardware
+      counts[event] = double(values[0]) * double(values[1]) / double(values[2]);
+    }
+#endif
+    return counts;
+  }
+
+  /* The counts of count operations, less those of the loop around them. */
+  static Counts perOperation(const Counts& total, const Counts& overhead, size_t count) {
+    Counts result;
+    for (int event = 0; event < kNumEvents; event++) {
+      double net = total[event] - overhead[event]; // NaN if either is
+      result[event] = std::isnan(net) ? net : std::max(net, 0.0) / std::max<size_t>(count, 1);
+    }
+    return result;
+  }
+
+  /* Counts per operation, as "cycles 123.45, instructions 67.89, ...". */
+  static std::string describe(const Counts& counts) {
+    std::string result;
+    for (int event = 0; event < kNumEvents; event++) {
+      char value[32];
+      if (std::isnan(counts[event])) std::snprintf(value, sizeof(value), "n/a");
+      else std::snprintf(value, sizeof(value), "%.2f", counts[event]);
+      result += std::string(event ? ", " : "") + name(Event(event)) + " " + value;
+    }
+    return result;
+  }
+
+  /**
+   * What the last timing measured, per operation, under a name such as
+   * "Query". The timing functions record; the reports take them to print.
+   */
+  void record(const std::string& operation, const Counts& counts) {
+    readings.push_back(std::make_pair(operation, counts));
+  }
+
+  std::vector<std::pair<std::string, Counts>> takeReadings() {
+    std::vector<std::pair<std::string, Counts>> result;
+    result.swap(readings);
+    return result;
+  }
+
+  void clearReadings() {
+    readings.clear();
+  }
+
+private:
+  PerfCounters() {
+    fds.fill(-1);
+  }
+
+#if defined(__linux__)
+  static uint64_t cacheEvent(uint64_t cache) {
+    return cache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) | (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+  }
+#endif
+
+  enum class Request { Start, Stop };
+
+  void control(Request request) {
+#if defined(__linux__)
+    for (int fd : fds) {
+      if (fd < 0) continue;
+      if (request == Request::Start) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      } else {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      }
+    }
+#else
+    (void) request;
+#endif
+  }
+
+  std::array<int, kNumEvents> fds;
+  std::string why;
+  std::vector<std::pair<std::string, Counts>> readings;
+
+  PerfCounters(PerfCounters const &) = delete;
+  void operator=(PerfCounters const &) = delete;
+};
+
+/* Keeps the compiler from dropping a computation whose result goes unused. */
+template <typename T>
+inline void keepAlive(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+/**
+ * Runs body(i) for every i < count. With the counters enabled it also
+ * counts them, then counts overhead(i) for every i, which should do all
+ * that body does except the operation itself (drawing the key, reading the
+ * clock), and records the difference per operation under the given name.
+ */
+template <typename Body, typename Overhead>
+void countOperations(const std::string& operation, size_t count, Body body, Overhead overhead) {
+  PerfCounters& counters = PerfCounters::current();
+  if (!counters.enabled()) {
+    for (size_t i = 0; i < count; i++) body(i);
+    return;
+  }
+  auto total = counters.measure([&] { for (size_t i = 0; i < count; i++) body(i); });
+  auto loop = counters.measure([&] { for (size_t i = 0; i < count; i++) overhead(i); });
+  counters.record(operation, PerfCounters::perOperation(total, loop, count));
+}
+
+#endif
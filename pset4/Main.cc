@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string>
 #include <stddef.h>
 #include "HashTable.h"
 #include "PerfectlyBalancedTree.h"
@@ -20,7 +21,21 @@ const size_t kNumLookups = 1 << 18;
 /* For the "working set" test case, the number of working sets. */
 const size_t kNumWorkingSets = kTreeSize >> 6;
 
-int main() {
+/* With --counters, the timings of lookups at random and in working sets
+ * are followed by hardware counters per lookup (see PerfCounters.h).
+ */
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "--counters") {
+      if (!PerfCounters::current().enable()) {
+        std::cerr << "Hardware counters unavailable (" << PerfCounters::current().reason() << ")" << std::endl;
+      }
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--counters]" << std::endl;
+      return 1;
+    }
+  }
+
   std::cout << "Correctness Tests" << std::endl;
   std::cout << "  Balanced:           " << (checkCorrectness<PerfectlyBalancedTree>(kTreeSize, kNumLookups) ? "pass" : "fail") << std::endl;
   std::cout << "  Weight-Balanced:    " << (checkCorrectness<WeightBalancedTree>(kTreeSize, kNumLookups) ? "pass" : "fail") << std::endl;
@@ -47,19 +62,29 @@ int main() {
 
   std::cout << "Access Elements in Working Set Batches:" << std::endl;
   std::cout << "  Balanced:           " << timeWorkingSets<PerfectlyBalancedTree>(kNumWorkingSets, kNumWorkingSets, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << "  Weight-Balanced:    " << timeWorkingSets<WeightBalancedTree>(kNumWorkingSets, kNumWorkingSets, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << "  Splay:              " << timeWorkingSets<SplayTree>(kNumWorkingSets, kNumWorkingSets, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << "  std::set:           " << timeWorkingSets<StdSetTree>(kNumWorkingSets, kNumWorkingSets, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << "  std::unordered_set: " << timeWorkingSets<HashTable>(kNumWorkingSets, kNumWorkingSets, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << std::endl;
 
   auto uniform = std::uniform_int_distribution<int>(0, kTreeSize-1);
   std::cout << "Access Elements Uniformly at Random:" << std::endl;
   std::cout << "  Balanced:           " << timeDistribution<PerfectlyBalancedTree>(uniform, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << "  Weight-Balanced:    " << timeDistribution<WeightBalancedTree>(uniform, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << "  Splay:              " << timeDistribution<SplayTree>(uniform, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << "  std::set:           " << timeDistribution<StdSetTree>(uniform, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << "  std::unordered_set: " << timeDistribution<HashTable>(uniform, kNumLookups) << " ms" << std::endl;
+  printCounters();
   std::cout << std::endl;
 
   // Some Zipfian distributed tests
@@ -67,10 +92,15 @@ int main() {
     auto distribution_z = zipfian(kTreeSize, z);
     std::cout << "Access Elements According to a Zipf(" << z << ") Distribution:" << std::endl;
     std::cout << "  Balanced:           " << timeDistribution<PerfectlyBalancedTree>(distribution_z, kNumLookups) << " ms" << std::endl;
+    printCounters();
     std::cout << "  Weight-Balanced:    " << timeDistribution<WeightBalancedTree>(distribution_z, kNumLookups) << " ms" << std::endl;
+    printCounters();
     std::cout << "  Splay:              " << timeDistribution<SplayTree>(distribution_z, kNumLookups) << " ms" << std::endl;
+    printCounters();
     std::cout << "  std::set:           " << timeDistribution<StdSetTree>(distribution_z, kNumLookups) << " ms" << std::endl;
+    printCounters();
     std::cout << "  std::unordered_set: " << timeDistribution<HashTable>(distribution_z, kNumLookups) << " ms" << std::endl;
+    printCounters();
     std::cout << std::endl;
   }
 }
@@ -14,6 +14,7 @@
 #include <iostream>
 #include <typeinfo>
 #include "SplayTree.h"
+#include "PerfCounters.h"
 
 /* The random seed used throughout the run. */
 static const size_t kRandomSeed = 137;
@@ -32,7 +33,8 @@ std::discrete_distribution<int> zipfian(size_t count, double z);
  * can be performed on a BST of the specified type. The number of elements in
  * the underlying tree will be equal to the number of distinct probabilities,
  * and the assumption is that the elements will be 0, 1, 2, ...,
- * probabilities.size() - 1.
+ * probabilities.size() - 1. With the hardware counters enabled, the lookups
+ * are also counted (see PerfCounters.h), for printCounters to report.
  */
 template <typename BST, typename ProbabilityDistribution>
 double timeDistribution(ProbabilityDistribution& gen,
@@ -45,13 +47,26 @@ double timeDistribution(ProbabilityDistribution& gen,
 
   std::chrono::high_resolution_clock::duration total = std::chrono::high_resolution_clock::duration::zero();
 
-  for (size_t i = 0; i < numLookups; i++) {
+  // The counters' second pass draws the same keys and reads the clock, but
+  // leaves out the tree.
+  std::default_random_engine overheadEngine = engine;
+  ProbabilityDistribution overheadGen = gen;
+  std::chrono::high_resolution_clock::duration overhead = std::chrono::high_resolution_clock::duration::zero();
+  PerfCounters::current().clearReadings();
+
+  countOperations("lookup", numLookups, [&](size_t) {
     auto index = gen(engine);
     auto start = std::chrono::high_resolution_clock::now();
     tree.contains(index);
     auto end = std::chrono::high_resolution_clock::now();
     total += end - start;
-  }
+  }, [&](size_t) {
+    auto index = overheadGen(overheadEngine);
+    auto start = std::chrono::high_resolution_clock::now();
+    keepAlive(index);
+    auto end = std::chrono::high_resolution_clock::now();
+    overhead += end - start;
+  });
 
   return std::chrono::duration_cast<std::chrono::nanoseconds>(total).count() / 1.0e6;
 }
@@ -127,6 +142,7 @@ double timeReverseSequential(size_t count) {
  * number of lookups that are clustered on a small number of elements. Each
  * group of elements that's repeatedly queried is called a "working set"
  * and it's known that splay trees perform particularly well on this case.
+ * The lookups are counted like those of timeDistribution.
  */
 template <typename BST>
 double timeWorkingSets(size_t numElems, size_t numSets, size_t numLookups) {
@@ -140,7 +156,11 @@ double timeWorkingSets(size_t numElems, size_t numSets, size_t numLookups) {
 
   std::chrono::high_resolution_clock::duration total = std::chrono::high_resolution_clock::duration::zero();
 
-  for (size_t i = 0; i < numLookups; i++) {
+  std::default_random_engine overheadEngine = engine;
+  std::chrono::high_resolution_clock::duration overhead = std::chrono::high_resolution_clock::duration::zero();
+  PerfCounters::current().clearReadings();
+
+  countOperations("lookup", numLookups, [&](size_t i) {
         size_t blockId = (double(i) / numLookups) * numSets;
     int index = gen(engine) + blockId * numElems / numSets;
     
@@ -148,12 +168,29 @@ double timeWorkingSets(size_t numElems, size_t numSets, size_t numLookups) {
     tree.contains(index);
     auto end = std::chrono::high_resolution_clock::now();
     total += end - start;
-  }
+  }, [&](size_t i) {
+    size_t blockId = (double(i) / numLookups) * numSets;
+    int index = gen(overheadEngine) + blockId * numElems / numSets;
+    auto start = std::chrono::high_resolution_clock::now();
+    keepAlive(index);
+    auto end = std::chrono::high_resolution_clock::now();
+    overhead += end - start;
+  });
 
   return std::chrono::duration_cast<std::chrono::nanoseconds>(total).count() / 1.0e6;
 }
 
 
+/**
+ * Print the hardware counts per lookup of the last timing, if the counters
+ * are enabled (see PerfCounters.h).
+ */
+inline void printCounters() {
+  for (const auto& reading : PerfCounters::current().takeReadings()) {
+    std::cout << "      " << PerfCounters::describe(reading.second) << " / " << reading.first << std::endl;
+  }
+}
+
 /**
  * Runs some basic correctness checks to ensure that the tree works correctly.
  * This involves looking up all the expected elements and a few that aren't
@@ -0,0 +1,27 @@
+#ifndef Batch_Included
+#define Batch_Included
+
+#include <cstddef>
+
+/**
+ * Support for the batched operations of the tables, contains_many and
+ * insert_many. Keys are processed kBatchSize at a time: every key of a batch
+ * is hashed and its buckets are prefetched before the first of them is
+ * looked at. By the time the probes are resolved, most of those buckets have
+ * arrived in cache, so a batch waits for memory roughly once instead of once
+ * per key.
+ *
+ * kBatchSize is about as many cache misses as a core can have in flight;
+ * larger batches would see their first prefetches evicted again.
+ */
+static const size_t kBatchSize = 16;
+
+inline void prefetch(const void* address) {
+#if defined(__GNUC__)
+  __builtin_prefetch(address);
+#else
+  (void) address;
+#endif
+}
+
+#endif
@@ -0,0 +1,192 @@
+#include "BucketizedCuckooHashTable.h"
+
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const int EMPTY = INT_MIN;
+
+/* Returns a bitmask with bit i set if keys[i] == value. */
+static inline unsigned match_key(const int* keys, int value) {
+#if defined(__SSE2__)
+  __m128i bucket = _mm_load_si128(reinterpret_cast<const __m128i*>(keys));
+  __m128i equal = _mm_cmpeq_epi32(bucket, _mm_set1_epi32(value));
+  return _mm_movemask_ps(_mm_castsi128_ps(equal));
+#else
+  return (keys[0] == value) | (keys[1] == value) << 1 |
+         (keys[2] == value) << 2 | (keys[3] == value) << 3;
+#endif
+}
+
+template <typename Hash, typename Capacity>
+BasicBucketizedCuckooHashTable<Hash, Capacity>::BasicBucketizedCuckooHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
+{
+  this->hash_family = family;
+  this->hash_function_first = sampleHash<Hash>(family);
+  this->hash_function_second = sampleHash<Hash>(family);
+  this->capacity = Capacity((numBuckets + kSlotsPerBucket - 1) / kSlotsPerBucket);
+  this->buckets = std::vector<Bucket>(this->capacity.size(), Bucket{{EMPTY, EMPTY, EMPTY, EMPTY}});
+  this->contains_empty_key = false;
+}
+
+template <typename Hash, typename Capacity>
+BasicBucketizedCuckooHashTable<Hash, Capacity>::~BasicBucketizedCuckooHashTable()
+{
+  // vectors clean up after themselves
+}
+
+template <typename Hash, typename Capacity>
+void BasicBucketizedCuckooHashTable<Hash, Capacity>::insert(int data)
+{
+  if (data == EMPTY) {
+    this->contains_empty_key = true;
+    return;
+  }
+  if (this->contains(data)) return;
+  if (!this->place(data)) this->rehash(data);
+}
+
+template <typename Hash, typename Capacity>
+bool BasicBucketizedCuckooHashTable<Hash, Capacity>::place(int& data)
+{
+  size_t from = this->buckets.size(); // bucket the carried key was evicted from
+  for (size_t displacements = 0; displacements <= kMaxDisplacements; displacements++) {
+    auto indices = this->indices_for_data(data);
+    for (size_t index : {indices.first, indices.second}) {
+      unsigned free = match_key(this->buckets[index].keys, EMPTY);
+      if (free) {
+        this->buckets[index].keys[__builtin_ctz(free)] = data;
+        return true;
+      }
+    }
+
+    // both buckets full; evict a random key, never back to where data came from
+    size_t victim;
+    if (indices.first == from) {
+      victim = indices.second;
+    } else if (indices.second == from) {
+      victim = indices.first;
+    } else {
+      victim = (this->engine() & 1) ? indices.first : indices.second;
+    }
+    std::swap(data, this->buckets[victim].keys[this->engine() % kSlotsPerBucket]);
+    from = victim;
+  }
+  return false;
+}
+
+template <typename Hash, typename Capacity>
+void BasicBucketizedCuckooHashTable<Hash, Capacity>::rehash(int pending)
+{
+  std::vector<int> elements(1, pending);
+  for (const auto& bucket : this->buckets) {
+    for (int key : bucket.keys) {
+      if (key != EMPTY) elements.push_back(key);
+    }
+  }
+
+  bool success = false;
+  while (!success) {
+    this->hash_function_first = sampleHash<Hash>(this->hash_family);
+    this->hash_function_second = sampleHash<Hash>(this->hash_family);
+    for (auto& bucket : this->buckets) {
+      for (int& key : bucket.keys) key = EMPTY;
+    }
+
+    success = true;
+    for (int element : elements) {
+      if (!this->place(element)) {
+        success = false;
+        break;
+      }
+    }
+  }
+}
+
+template <typename Hash, typename Capacity>
+bool BasicBucketizedCuckooHashTable<Hash, Capacity>::contains(int data) const
+{
+  if (data == EMPTY) return this->contains_empty_key;
+  return this->contains_at(data, this->indices_for_data(data));
+}
+
+template <typename Hash, typename Capacity>
+bool BasicBucketizedCuckooHashTable<Hash, Capacity>::contains_at(int data, std::pair<size_t, size_t> indices) const
+{
+  return (match_key(this->buckets[indices.first].keys, data) |
+          match_key(this->buckets[indices.second].keys, data)) != 0;
+}
+
+template <typename Hash, typename Capacity>
+void BasicBucketizedCuckooHashTable<Hash, Capacity>::contains_many(const int* keys, size_t n, bool* out) const
+{
+  size_t hashes1[kBatchSize];
+  size_t hashes2[kBatchSize];
+  std::pair<size_t, size_t> indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hash_function_first, keys + start, count, hashes1);
+    hashMany(this->hash_function_second, keys + start, count, hashes2);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = std::make_pair(this->capacity.index(hashes1[i]), this->capacity.index(hashes2[i]));
+      prefetch(&this->buckets[indices[i].first]);
+      prefetch(&this->buckets[indices[i].second]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      int data = keys[start + i];
+      out[start + i] = data == EMPTY ? this->contains_empty_key : this->contains_at(data, indices[i]);
+    }
+  }
+}
+
+template <typename Hash, typename Capacity>
+void BasicBucketizedCuckooHashTable<Hash, Capacity>::insert_many(const int* keys, size_t n)
+{
+  size_t hashes1[kBatchSize];
+  size_t hashes2[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hash_function_first, keys + start, count, hashes1);
+    hashMany(this->hash_function_second, keys + start, count, hashes2);
+    for (size_t i = 0; i < count; i++) {
+      prefetch(&this->buckets[this->capacity.index(hashes1[i])]);
+      prefetch(&this->buckets[this->capacity.index(hashes2[i])]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      this->insert(keys[start + i]);
+    }
+  }
+}
+
+template <typename Hash, typename Capacity>
+void BasicBucketizedCuckooHashTable<Hash, Capacity>::remove(int data)
+{
+  if (data == EMPTY) {
+    this->contains_empty_key = false;
+    return;
+  }
+  auto indices = this->indices_for_data(data);
+  for (size_t index : {indices.first, indices.second}) {
+    unsigned found = match_key(this->buckets[index].keys, data);
+    if (found) {
+      this->buckets[index].keys[__builtin_ctz(found)] = EMPTY;
+      return;
+    }
+  }
+}
+
+template <typename Hash, typename Capacity>
+std::pair<size_t, size_t> BasicBucketizedCuckooHashTable<Hash, Capacity>::indices_for_data(int data) const
+{
+  size_t index_first = this->capacity.index(this->hash_function_first(data));
+  size_t index_second = this->capacity.index(this->hash_function_second(data));
+  return std::pair<size_t, size_t>(index_first, index_second);
+}
+
+#define INSTANTIATE(Hash, Capacity) template class BasicBucketizedCuckooHashTable<Hash, Capacity>;
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
@@ -0,0 +1,116 @@
+#ifndef BucketizedCuckooHashTable_Included
+#define BucketizedCuckooHashTable_Included
+
+#include "Hashes.h"
+#include "Capacity.h"
+#include "Batch.h"
+
+#include <vector>
+#include <random>
+
+/**
+ * A (2, 4)-cuckoo hash table: every key has two candidate buckets, chosen by
+ * two hash functions, and every bucket holds four keys. A bucket is 16 bytes
+ * and aligned, so it never straddles a cache line and all four keys can be
+ * compared with a single SSE2 instruction. Lookups touch at most two cache
+ * lines, and unlike the one-slot CuckooHashTable the table keeps working at
+ * load factors well above 90%.
+ *
+ * Empty slots hold a sentinel key. The sentinel itself can still be stored:
+ * whether it is in the table is tracked in a separate flag.
+ *
+ * Like the other tables it is templated on its hash function, and on a
+ * Capacity policy (see Capacity.h) that maps hashes onto buckets.
+ */
+template <typename Hash, typename Capacity = ModuloCapacity>
+class BasicBucketizedCuckooHashTable {
+public:
+  /**
+   * Constructs a new bucketized cuckoo table with room for at least the
+   * specified number of keys, using hash functions drawn from the indicated
+   * family of hash functions. The keys are spread over numBuckets / 4
+   * buckets, rounded up. Because our testing harness attempts to exercise a
+   * number of different load factors, the table never changes its size.
+   */
+  BasicBucketizedCuckooHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+
+  /**
+   * Cleans up all memory allocated by this hash table.
+   */
+  ~BasicBucketizedCuckooHashTable();
+
+  /**
+   * Inserts the specified element into this hash table. If the element already
+   * exists, this operation is a no-op.
+   *
+   * If neither candidate bucket has a free slot, a random key from one of
+   * them is evicted to its other bucket, and so on. If that takes more than
+   * kMaxDisplacements steps, the table is rehashed with new hash functions.
+   */
+  void insert(int key);
+
+  /**
+   * Returns whether the specified key is contained in this hash table.
+   */
+  bool contains(int key) const;
+
+  /**
+   * Removes the specified element from this hash table. If the element is not
+   * present in the hash table, this operation is a no-op.
+   */
+  void remove(int key);
+
+  /**
+   * Batched lookup: sets out[i] to contains(keys[i]) for every i < n, after
+   * prefetching both buckets of a whole batch of keys (see Batch.h).
+   */
+  void contains_many(const int* keys, size_t n, bool* out) const;
+
+  /**
+   * Inserts keys[0], ..., keys[n - 1], prefetching both of their buckets a
+   * batch at a time.
+   */
+  void insert_many(const int* keys, size_t n);
+
+  static const size_t kSlotsPerBucket = 4;
+  static const size_t kMaxDisplacements = 500;
+
+private:
+  struct alignas(16) Bucket {
+    int keys[kSlotsPerBucket];
+  };
+
+  std::pair<size_t, size_t> indices_for_data(int data) const;
+
+  /* contains, given both buckets of data. */
+  bool contains_at(int data, std::pair<size_t, size_t> indices) const;
+
+  /* Places data without checking for duplicates. Returns false, with the
+   * table still holding every element it had, if data had to be dropped
+   * because the displacement limit was hit; 'data' then holds the element
+   * left over.
+   */
+  bool place(int& data);
+  void rehash(int pending);
+
+  std::shared_ptr<HashFamily> hash_family;
+  Hash hash_function_first;
+  Hash hash_function_second;
+  std::vector<Bucket> buckets;
+  Capacity capacity;
+  bool contains_empty_key;
+  std::minstd_rand engine;
+
+  /* Fun with C++: these next two lines disable implicitly-generated copy
+   * functions that would otherwise cause weird errors if you tried to
+   * implicitly copy an object of this type. You don't need to touch these
+   * lines.
+   */
+  BasicBucketizedCuckooHashTable(BasicBucketizedCuckooHashTable const &) = delete;
+  void operator=(BasicBucketizedCuckooHashTable const &) = delete;
+};
+
+/* The type-erased table, usable with every hash family. */
+using BucketizedCuckooHashTable = BasicBucketizedCuckooHashTable<HashFunction>;
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef Capacity_Included
+#define Capacity_Included
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Capacity policies for the open-addressing tables. A policy decides how many
+ * buckets a table really gets for a requested bucket count, and how hash
+ * values and probe positions are mapped onto those buckets. Every policy
+ * provides:
+ *
+ *    size()             the actual number of buckets
+ *    index(hash)        the home bucket for a hash value
+ *    next(index)        the bucket after index, wrapping around
+ *    previous(index)    the bucket before index, wrapping around
+ *    distance(from, to) how many steps forward it takes to get from 'from'
+ *                       to 'to'
+ *
+ * The tables take the policy as a template parameter, so none of these calls
+ * costs more than the arithmetic in it.
+ */
+
+/* Policy: ModuloCapacity
+ * ----------------------------------------------------------------------------
+ * Uses exactly the requested number of buckets, which keeps the load factors
+ * of our testing harness exact. Mapping a hash to its home bucket takes one
+ * integer division; stepping through a probe sequence takes none.
+ */
+class ModuloCapacity {
+public:
+  explicit ModuloCapacity(size_t numBuckets = 0) : buckets(numBuckets) {}
+
+  size_t size() const {
+    return buckets;
+  }
+
+  size_t index(size_t hash) const {
+    return hash % buckets;
+  }
+
+  size_t next(size_t index) const {
+    return ++index == buckets ? 0 : index;
+  }
+
+  size_t previous(size_t index) const {
+    return (index == 0 ? buckets : index) - 1;
+  }
+
+  size_t distance(size_t from, size_t to) const {
+    return to >= from ? to - from : to + buckets - from;
+  }
+
+private:
+  size_t buckets;
+};
+
+/* Policy: PowerOfTwoCapacity
+ * ----------------------------------------------------------------------------
+ * Rounds the requested number of buckets up to the next power of two, so
+ * every mapping is a single mask. The real load factor can end up as low as
+ * half of the one asked for.
+ */
+class PowerOfTwoCapacity {
+public:
+  explicit PowerOfTwoCapacity(size_t numBuckets = 0) : mask(roundUp(numBuckets) - 1) {}
+
+  size_t size() const {
+    return mask + 1;
+  }
+
+  size_t index(size_t hash) const {
+    return hash & mask;
+  }
+
+  size_t next(size_t index) const {
+    return (index + 1) & mask;
+  }
+
+  size_t previous(size_t index) const {
+    return (index - 1) & mask;
+  }
+
+  size_t distance(size_t from, size_t to) const {
+    return (to - from) & mask;
+  }
+
+private:
+  size_t mask;
+
+  static size_t roundUp(size_t n) {
+    size_t result = 1;
+    while (result < n) result <<= 1;
+    return result;
+  }
+};
+
+/* Policy: FastRangeCapacity
+ * ----------------------------------------------------------------------------
+ * Uses exactly the requested number of buckets and maps hashes onto them with
+ * Lemire's multiply-shift "fast range" reduction instead of a division. It
+ * scales the low 31 bits of the hash, the widest range that every family in
+ * Hashes.h fills: the polynomial families stay below 2^31 - 1, while
+ * multiply-shift and compact tabulation give 32 bits, and tabulation and the
+ * Mersenne families up to 64 and 61 bits whose low bits are just as uniform.
+ * The bucket is chosen by the top of those 31 bits, which makes the policy a
+ * poor match for identityHash, whose small keys all land in the first few
+ * buckets.
+ */
+class FastRangeCapacity {
+public:
+  explicit FastRangeCapacity(size_t numBuckets = 0) : buckets(numBuckets) {}
+
+  size_t size() const {
+    return buckets;
+  }
+
+  size_t index(size_t hash) const {
+    return (uint64_t(hash & kHashMask) * buckets) >> kHashBits;
+  }
+
+  size_t next(size_t index) const {
+    return ++index == buckets ? 0 : index;
+  }
+
+  size_t previous(size_t index) const {
+    return (index == 0 ? buckets : index) - 1;
+  }
+
+  size_t distance(size_t from, size_t to) const {
+    return to >= from ? to - from : to + buckets - from;
+  }
+
+private:
+  static const unsigned kHashBits = 31;
+  static const uint64_t kHashMask = (uint64_t(1) << kHashBits) - 1;
+
+  size_t buckets;
+};
+
+/**
+ * Macro: FOR_EACH_CAPACITY(X, Hash)
+ * ----------------------------------------------------------------------------
+ * Expands X(Hash, Capacity) once for every capacity policy. Combined with
+ * FOR_EACH_HASH, this lets the table implementations explicitly instantiate
+ * every hasher/policy pair.
+ */
+#define FOR_EACH_CAPACITY(X, Hash) \
+  X(Hash, ModuloCapacity)          \
+  X(Hash, PowerOfTwoCapacity)      \
+  X(Hash, FastRangeCapacity)
+
+#endif
@@ -1,45 +1,141 @@
-#include <assert.h>
 #include "ChainedHashTable.h"
-#include <iostream>
 
+#include <algorithm>
 
-ChainedHashTable::ChainedHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family) {
-  this->hashFunction = family->get();
-//  this->numBuckets = numBuckets;
-  this->buckets = std::vector<std::forward_list<int>>(numBuckets, std::forward_list<int>(0));
+static const uint32_t NIL = UINT32_MAX;
+static const uint32_t EMPTY_BUCKET = UINT32_MAX - 1;
+
+template <typename Hash>
+BasicChainedHashTable<Hash>::BasicChainedHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family) {
+  this->hashFunction = sampleHash<Hash>(family);
+  this->buckets = std::vector<Node>(numBuckets, Node{0, EMPTY_BUCKET});
+  this->nodes.reserve(numBuckets);
+  this->free_list = NIL;
 }
 
-ChainedHashTable::~ChainedHashTable() {
+template <typename Hash>
+BasicChainedHashTable<Hash>::~BasicChainedHashTable() {
   // should not need to do anything yay pointers
 }
 
-void ChainedHashTable::insert(int data) {
-  size_t index = this->index_for_data(data);
-  auto chain = this->buckets.at(index);
-  auto iterator = std::find(chain.begin(), chain.end(), data);
-  if (iterator == chain.end()) { // did not find element, inserting
-    chain.push_front(data);
-    this->buckets.at(index) = chain;
+template <typename Hash>
+void BasicChainedHashTable<Hash>::insert(int data) {
+  insert_at(data, this->index_for_data(data));
+}
+
+template <typename Hash>
+void BasicChainedHashTable<Hash>::insert_at(int data, size_t index) {
+  Node& bucket = this->buckets[index];
+  if (bucket.next == EMPTY_BUCKET) { // the first key goes into the bucket
+    bucket.key = data;
+    bucket.next = NIL;
+    return;
+  }
+  if (contains_in(data, bucket)) return; // found data; don't insert duplicate
+
+  uint32_t node = this->free_list;
+  if (node != NIL) { // reuse a removed node
+    this->free_list = this->nodes[node].next;
+  } else {
+    node = this->nodes.size();
+    this->nodes.push_back(Node());
   }
+  // the node goes second, after the key in the bucket
+  this->nodes[node].key = data;
+  this->nodes[node].next = this->buckets[index].next;
+  this->buckets[index].next = node;
 }
 
-bool ChainedHashTable::contains(int data) const {
-  size_t index = this->index_for_data(data);
-  auto chain = this->buckets.at(index);
-  auto iterator = std::find(chain.begin(), chain.end(), data);
-  bool contains_data = iterator != chain.end();
-  return contains_data;
+template <typename Hash>
+bool BasicChainedHashTable<Hash>::contains(int data) const {
+  return contains_in(data, this->buckets[this->index_for_data(data)]);
 }
 
-void ChainedHashTable::remove(int data) {
-  size_t index = this->index_for_data(data);
-  auto chain = this->buckets.at(index);
-  chain.remove(data);
-  this->buckets.at(index) = chain;
+template <typename Hash>
+bool BasicChainedHashTable<Hash>::contains_in(int data, const Node& bucket) const {
+  if (bucket.next == EMPTY_BUCKET) return false;
+  if (bucket.key == data) return true;
+  for (uint32_t node = bucket.next; node != NIL; node = this->nodes[node].next) {
+    if (this->nodes[node].key == data) return true;
+  }
+  return false;
 }
 
-size_t ChainedHashTable::index_for_data(int data) const {
+template <typename Hash>
+void BasicChainedHashTable<Hash>::remove(int data) {
+  Node& bucket = this->buckets[this->index_for_data(data)];
+  if (bucket.next == EMPTY_BUCKET) return;
+  if (bucket.key == data) {
+    uint32_t node = bucket.next;
+    if (node == NIL) {
+      bucket.next = EMPTY_BUCKET;
+      return;
+    }
+    bucket = this->nodes[node]; // pull the second key into the bucket
+    this->nodes[node].next = this->free_list;
+    this->free_list = node;
+    return;
+  }
+
+  uint32_t* link = &bucket.next;
+  while (*link != NIL) {
+    uint32_t node = *link;
+    if (this->nodes[node].key == data) {
+      *link = this->nodes[node].next; // unlink and hand node to the free list
+      this->nodes[node].next = this->free_list;
+      this->free_list = node;
+      return;
+    }
+    link = &this->nodes[node].next;
+  }
+}
+
+template <typename Hash>
+void BasicChainedHashTable<Hash>::contains_many(const int* keys, size_t n, bool* out) const {
+  size_t hashes[kBatchSize];
+  size_t indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction, keys + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = hashes[i] % this->buckets.size();
+      prefetch(&this->buckets[indices[i]]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      const Node& bucket = this->buckets[indices[i]];
+      if (bucket.next != NIL && bucket.next != EMPTY_BUCKET && bucket.key != keys[start + i]) {
+        prefetch(&this->nodes[bucket.next]);
+      }
+    }
+    for (size_t i = 0; i < count; i++) {
+      out[start + i] = contains_in(keys[start + i], this->buckets[indices[i]]);
+    }
+  }
+}
+
+template <typename Hash>
+void BasicChainedHashTable<Hash>::insert_many(const int* keys, size_t n) {
+  size_t hashes[kBatchSize];
+  size_t indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction, keys + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = hashes[i] % this->buckets.size();
+      prefetch(&this->buckets[indices[i]]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      insert_at(keys[start + i], indices[i]);
+    }
+  }
+}
+
+template <typename Hash>
+size_t BasicChainedHashTable<Hash>::index_for_data(int data) const {
   size_t hash_value = this->hashFunction(data);
   size_t index = hash_value % this->buckets.size();
   return index;
-}
\ No newline at end of file
+}
+
+#define INSTANTIATE(Hash) template class BasicChainedHashTable<Hash>;
+FOR_EACH_HASH(INSTANTIATE)
@@ -2,12 +2,19 @@
 #define ChainedHashTable_Included
 
 #include "Hashes.h"
+#include "Batch.h"
 #include <vector>
-#include <forward_list>
-#include <algorithm>
+#include <cstdint>
 
 
-class ChainedHashTable {
+/**
+ * The table is templated on the type of its hash function. With Hash =
+ * HashFunction it accepts any HashFamily; with one of the concrete hashers
+ * from Hashes.h (e.g. TabulationHash) it must be given the matching family,
+ * and the hash is inlined into every probe.
+ */
+template <typename Hash>
+class BasicChainedHashTable {
 public:
   /**
    * Constructs a new chained hash table with the specified number of buckets,
@@ -17,18 +24,18 @@ public:
    * table has initially be created.
    *
    * You can choose a hash function out of the family of hash functions by
-   * declaring a variable of type HashFunction and assigning it the value
-   * family->get(). For example:
+   * declaring a variable of type Hash and assigning it the value
+   * sampleHash<Hash>(family). For example:
    *
-   *    HashFunction h;
-   *    h = family->get();
+   *    Hash h;
+   *    h = sampleHash<Hash>(family);
    */
-  ChainedHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+  BasicChainedHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
   
   /**
    * Cleans up all memory allocated by this hash table.
    */
-  ~ChainedHashTable();
+  ~BasicChainedHashTable();
   
   /**
    * Inserts the specified element into this hash table. If the element already
@@ -46,20 +53,57 @@ public:
    * present in the hash table, this operation is a no-op.
    */
   void remove(int key);
+
+  /**
+   * Batched lookup: sets out[i] to contains(keys[i]) for every i < n. For a
+   * whole batch of keys, the buckets are prefetched first, then the next
+   * node of every chain whose bucket doesn't hold the key itself, and only
+   * then are the chains walked (see Batch.h).
+   */
+  void contains_many(const int* keys, size_t n, bool* out) const;
+
+  /**
+   * Inserts keys[0], ..., keys[n - 1], prefetching their buckets a batch at
+   * a time.
+   */
+  void insert_many(const int* keys, size_t n);
+
   size_t index_for_data(int data) const;
 private:
-  HashFunction hashFunction;
-  std::vector<std::forward_list<int>> buckets;
+  /* Chains live in a single node pool and link to each other by 32-bit
+   * indices, so no operation allocates except when the pool has to grow.
+   * The first key of every chain is stored in the bucket itself, so a chain
+   * of one costs a single load; a bucket's next is the index of the second
+   * node, NIL if there is none, or EMPTY_BUCKET if the bucket holds no key.
+   * Removed nodes are threaded onto a free list and reused by later
+   * insertions.
+   */
+  struct Node {
+    int key;
+    uint32_t next;
+  };
+
+  /* contains, given data's bucket. */
+  bool contains_in(int data, const Node& bucket) const;
 
-//  size_t numBuckets;
+  /* insert, given the bucket of data. */
+  void insert_at(int data, size_t index);
+
+  Hash hashFunction;
+  std::vector<Node> buckets;
+  std::vector<Node> nodes;
+  uint32_t free_list;
 
   /* Fun with C++: these next two lines disable implicitly-generated copy
    * functions that would otherwise cause weird errors if you tried to
    * implicitly copy an object of this type. You don't need to touch these
    * lines.
    */
-  ChainedHashTable(ChainedHashTable const &) = delete;
-  void operator=(ChainedHashTable const &) = delete;
+  BasicChainedHashTable(BasicChainedHashTable const &) = delete;
+  void operator=(BasicChainedHashTable const &) = delete;
 };
 
+/* The type-erased table, usable with every hash family. */
+using ChainedHashTable = BasicChainedHashTable<HashFunction>;
+
 #endif
@@ -0,0 +1,341 @@
+/**
+ * compare-runs: reads the results of run-tests --csv or --json (see
+ * Results.h) for a baseline and a candidate build and reports every timing
+ * that changed by more than a threshold. Usage:
+ *
+ *    compare-runs [--threshold percent] [--alpha level] base... --vs candidate...
+ *
+ * Each file is one run. Given at least two runs on each side, a change only
+ * counts if Welch's t-test also finds it significant at the given level
+ * (one-sided, in the direction of the change); with a single run on either
+ * side the threshold alone decides. Timings are compared by their ns / op
+ * and, where the run sampled single operations, by their p99. The exit
+ * status is 1 if anything got slower, so a script can gate on it.
+ */
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/* One result: the fields of a record, by name, as text. */
+typedef std::map<std::string, std::string> Record;
+
+/* table, family, load factor and operation identify a timing across runs. */
+typedef std::tuple<std::string, std::string, std::string, std::string> Key;
+
+/* Splits one CSV line into its fields, undoing the quoting of Results.h. */
+static std::vector<std::string> splitCSV(const std::string& line) {
+  std::vector<std::string> fields(1);
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); i++) {
+    char c = line[i];
+    if (quoted) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+        fields.back() += '"';
+        i++;
+      } else if (c == '"') {
+        quoted = false;
+      } else {
+        fields.back() += c;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      fields.emplace_back();
+    } else if (c != '\r') {
+      fields.back() += c;
+    }
+  }
+  return fields;
+}
+
+static std::vector<Record> readCSV(std::istream& in, const std::string& path) {
+  std::string line;
+  if (!std::getline(in, line)) return {};
+  std::vector<std::string> names = splitCSV(line);
+  std::vector<Record> records;
+  while (std::getline(in, line)) {
+    if (line.empty()) continue;
+    std::vector<std::string> values = splitCSV(line);
+    if (values.size() != names.size()) throw std::runtime_error(path + ": malformed line: " + line);
+    Record record;
+    for (size_t i = 0; i < names.size(); i++) record[names[i]] = values[i];
+    records.push_back(record);
+  }
+  return records;
+}
+
+/* Just enough JSON for what Results.h writes: an array of flat objects
+ * whose values are strings, numbers or null. null reads as an empty string,
+ * as in the CSV files.
+ */
+class JSONReader {
+public:
+  JSONReader(const std::string& text, const std::string& path) : text(text), path(path), pos(0) {}
+
+  std::vector<Record> read() {
+    std::vector<Record> records;
+    expect('[');
+    if (peek() == ']') return records;
+    do {
+      records.push_back(readObject());
+    } while (accept(','));
+    expect(']');
+    return records;
+  }
+
+private:
+  Record readObject() {
+    Record record;
+    expect('{');
+    if (accept('}')) return record;
+    do {
+      std::string name = readString();
+      expect(':');
+      record[name] = readValue();
+    } while (accept(','));
+    expect('}');
+    return record;
+  }
+
+  std::string readValue() {
+    if (peek() == '"') return readString();
+    size_t start = pos;
+    while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && !std::isspace(text[pos])) pos++;
+    std::string value = text.substr(start, pos - start);
+    if (value.empty()) fail("expected a value");
+    return value == "null" ? "" : value;
+  }
+
+  std::string readString() {
+    expect('"');
+    std::string result;
+    while (pos < text.size() && text[pos] != '"') {
+      char c = text[pos++];
+      if (c == '\\' && pos < text.size()) {
+        c = text[pos++];
+        if (c == 'n') c = '\n';
+        else if (c == 't') c = '\t';
+      }
+      result += c;
+    }
+    expect('"');
+    return result;
+  }
+
+  char peek() {
+    while (pos < text.size() && std::isspace(text[pos])) pos++;
+    return pos < text.size() ? text[pos] : '\0';
+  }
+
+  bool accept(char c) {
+    if (peek() != c) return false;
+    pos++;
+    return true;
+  }
+
+  void expect(char c) {
+    if (!accept(c)) fail(std::string("expected '") + c + "'");
+  }
+
+  void fail(const std::string& why) {
+    throw std::runtime_error(path + ": " + why + " at offset " + std::to_string(pos));
+  }
+
+  const std::string& text;
+  const std::string& path;
+  size_t pos;
+};
+
+/* Reads a results file, telling the formats apart by their first character. */
+static std::vector<Record> readResults(const std::string& path) {
+  std::ifstream in(path);
+  if (!in) throw std::runtime_error("Can't read " + path);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  std::string text = contents.str();
+  size_t start = text.find_first_not_of(" \t\r\n");
+  if (start != std::string::npos && text[start] == '[') return JSONReader(text, path).read();
+  std::istringstream lines(text);
+  return readCSV(lines, path);
+}
+
+/* The continued fraction for the regularized incomplete beta function, by
+ * the modified Lentz method.
+ */
+static double betaFraction(double a, double b, double x) {
+  const double kTiny = 1e-300;
+  double c = 1, d = 1 - (a + b) * x / (a + 1);
+  if (std::fabs(d) < kTiny) d = kTiny;
+  d = 1 / d;
+  double result = d;
+  for (int m = 1; m <= 300; m++) {
+    for (int half = 0; half < 2; half++) {
+      double numerator = half == 0 ? m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m))
+                                   : -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+      d = 1 + numerator * d;
+      if (std::fabs(d) < kTiny) d = kTiny;
+      c = 1 + numerator / c;
+      if (std::fabs(c) < kTiny) c = kTiny;
+      d = 1 / d;
+      result *= d * c;
+      if (half == 1 && std::fabs(d * c - 1) < 1e-12) return result;
+    }
+  }
+  return result;
+}
+
+/* I_x(a, b), the regularized incomplete beta function. */
+static double incompleteBeta(double a, double b, double x) {
+  if (x <= 0) return 0;
+  if (x >= 1) return 1;
+  double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) +
+                          a * std::log(x) + b * std::log(1 - x));
+  if (x < (a + 1) / (a + b + 2)) return front * betaFraction(a, b, x) / a;
+  return 1 - front * betaFraction(b, a, 1 - x) / b;
+}
+
+/* P(T > t) for Student's t distribution with the given degrees of freedom. */
+static double tailProbability(double t, double degrees) {
+  double tail = 0.5 * incompleteBeta(degrees / 2, 0.5, degrees / (degrees + t * t));
+  return t > 0 ? tail : 1 - tail;
+}
+
+struct Sample {
+  double mean;
+  double variance;
+  size_t count;
+};
+
+static Sample summarize(const std::vector<double>& values) {
+  Sample sample = {0, 0, values.size()};
+  for (double value : values) sample.mean += value;
+  sample.mean /= values.size();
+  if (values.size() > 1) {
+    for (double value : values) sample.variance += (value - sample.mean) * (value - sample.mean);
+    sample.variance /= values.size() - 1;
+  }
+  return sample;
+}
+
+/**
+ * The one-sided p-value of Welch's t-test for the candidate's mean being
+ * larger than the baseline's (slower == true) or smaller. Needs two values
+ * on each side.
+ */
+static double welchPValue(const Sample& base, const Sample& candidate, bool slower) {
+  double baseTerm = base.variance / base.count;
+  double candidateTerm = candidate.variance / candidate.count;
+  double spread = baseTerm + candidateTerm;
+  if (spread == 0) return base.mean == candidate.mean ? 1 : 0; // no noise at all
+  double t = (candidate.mean - base.mean) / std::sqrt(spread);
+  double degrees = spread * spread / (baseTerm * baseTerm / (base.count - 1) +
+                                      candidateTerm * candidateTerm / (candidate.count - 1));
+  return tailProbability(slower ? t : -t, degrees);
+}
+
+struct Change {
+  std::string description;
+  double percent;
+  double pValue; // NaN when there were too few runs to test
+};
+
+static void printChanges(const char* title, std::vector<Change>& changes) {
+  std::sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) {
+    return std::fabs(a.percent) > std::fabs(b.percent);
+  });
+  std::cout << title << " (" << changes.size() << ")" << std::endl;
+  for (const auto& change : changes) {
+    std::cout << "  " << std::showpos << std::fixed << std::setw(8) << std::setprecision(1) << change.percent
+              << std::noshowpos << "%  ";
+    if (std::isnan(change.pValue)) std::cout << "           ";
+    else std::cout << "p = " << std::setw(5) << std::setprecision(3) << change.pValue << "  ";
+    std::cout << change.description << std::endl;
+  }
+}
+
+static void usage(const char* program) {
+  std::cerr << "Usage: " << program << " [--threshold percent] [--alpha level] base... --vs candidate..." << std::endl;
+  std::exit(2);
+}
+
+int main(int argc, char** argv) {
+  double threshold = 5;
+  double alpha = 0.05;
+  std::vector<std::string> basePaths, candidatePaths;
+  bool candidates = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--threshold" && i + 1 < argc) threshold = std::atof(argv[++i]);
+    else if (arg == "--alpha" && i + 1 < argc) alpha = std::atof(argv[++i]);
+    else if (arg == "--vs") candidates = true;
+    else if (arg.compare(0, 2, "--") == 0) usage(argv[0]);
+    else (candidates ? candidatePaths : basePaths).push_back(arg);
+  }
+  if (basePaths.empty() || candidatePaths.empty()) usage(argv[0]);
+
+  /* Every metric of every timing, with its values in the baseline runs and
+   * in the candidate runs.
+   */
+  typedef std::pair<Key, std::string> Metric;
+  std::map<Metric, std::vector<double>> values[2];
+  try {
+    for (int side = 0; side < 2; side++) {
+      for (const auto& path : side == 0 ? basePaths : candidatePaths) {
+        for (auto& record : readResults(path)) {
+          Key key(record["table"], record["family"], record["load_factor"], record["operation"]);
+          for (const char* metric : {"ns_per_op", "p99"}) {
+            if (!record[metric].empty()) values[side][Metric(key, metric)].push_back(std::atof(record[metric].c_str()));
+          }
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 2;
+  }
+
+  std::vector<Change> regressions, improvements;
+  size_t compared = 0;
+  for (const auto& entry : values[0]) {
+    auto other = values[1].find(entry.first);
+    if (other == values[1].end()) continue;
+    compared++;
+    Sample base = summarize(entry.second);
+    Sample candidate = summarize(other->second);
+    if (base.mean <= 0) continue;
+    double percent = 100 * (candidate.mean / base.mean - 1);
+    if (std::fabs(percent) <= threshold) continue;
+
+    double pValue = std::numeric_limits<double>::quiet_NaN();
+    if (base.count >= 2 && candidate.count >= 2) {
+      pValue = welchPValue(base, candidate, percent > 0);
+      if (pValue >= alpha) continue;
+    }
+
+    const Key& key = entry.first.first;
+    std::string description = std::get<0>(key) + " / " + std::get<1>(key);
+    if (!std::get<2>(key).empty()) description += " / load " + std::get<2>(key);
+    description += " / " + std::get<3>(key);
+    if (entry.first.second != "ns_per_op") description += " [" + entry.first.second + "]";
+    (percent > 0 ? regressions : improvements).push_back(Change{description, percent, pValue});
+  }
+
+  std::cout << "Compared " << compared << " timings from " << basePaths.size() << " baseline and "
+            << candidatePaths.size() << " candidate run(s), threshold " << threshold << "%";
+  if (basePaths.size() >= 2 && candidatePaths.size() >= 2) std::cout << ", alpha " << alpha;
+  std::cout << std::endl;
+  printChanges("Regressions", regressions);
+  printChanges("Improvements", improvements);
+  return regressions.empty() ? 0 : 1;
+}
@@ -0,0 +1,405 @@
+#include "ConcurrentCuckooHashTable.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+
+static const int EMPTY = -1;
+static const size_t kMaxDisplacements = 500; // for the random walk while rehashing
+
+template <typename Hash, typename Capacity>
+BasicConcurrentCuckooHashTable<Hash, Capacity>::BasicConcurrentCuckooHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
+{
+  this->hash_family = family;
+  this->capacity = Capacity(numBuckets / 2);
+  this->buckets_left.reset(new std::atomic<int>[this->capacity.size()]);
+  this->buckets_right.reset(new std::atomic<int>[this->capacity.size()]);
+  for (size_t index = 0; index < this->capacity.size(); index++) {
+    this->buckets_left[index].store(EMPTY, std::memory_order_relaxed);
+    this->buckets_right[index].store(EMPTY, std::memory_order_relaxed);
+  }
+  this->stripes.reset(new Stripe[kStripes + 1]);
+  for (size_t stripe = 0; stripe <= kStripes; stripe++) {
+    this->stripes[stripe].version.store(0, std::memory_order_relaxed);
+  }
+  for (auto& slot : this->stash) slot.store(EMPTY, std::memory_order_relaxed);
+  this->stash_size.store(0, std::memory_order_relaxed);
+
+  this->readers.reset(new Reader[kReaders]);
+  for (size_t reader = 0; reader < kReaders; reader++) {
+    this->readers[reader].functions.store(nullptr, std::memory_order_relaxed);
+  }
+
+  this->generations.emplace_back(new Functions{sampleHash<Hash>(family), sampleHash<Hash>(family)});
+  this->functions.store(this->generations.back().get(), std::memory_order_release);
+}
+
+template <typename Hash, typename Capacity>
+BasicConcurrentCuckooHashTable<Hash, Capacity>::~BasicConcurrentCuckooHashTable()
+{
+  // unique_ptrs clean up after themselves
+}
+
+template <typename Hash, typename Capacity>
+bool BasicConcurrentCuckooHashTable<Hash, Capacity>::contains(int data) const
+{
+  ReaderGuard reader(*this);
+  for (;;) {
+    const Functions* functions = reader.protect();
+    size_t left = this->capacity.index(functions->left(data));
+    size_t right = this->capacity.index(functions->right(data));
+    const std::atomic<uint32_t>& version_left = this->stripes[stripe_for(true, left)].version;
+    const std::atomic<uint32_t>& version_right = this->stripes[stripe_for(false, right)].version;
+    const std::atomic<uint32_t>& version_stash = this->stripes[kStashStripe].version;
+
+    uint32_t before_left = version_left.load(std::memory_order_acquire);
+    uint32_t before_right = version_right.load(std::memory_order_acquire);
+    uint32_t before_stash = version_stash.load(std::memory_order_acquire);
+    if ((before_left | before_right | before_stash) & 1 ||
+        this->functions.load(std::memory_order_acquire) != functions) {
+      std::this_thread::yield(); // a writer is busy here, or rehashed since we hashed
+      continue;
+    }
+
+    bool found = bucket(true, left).load(std::memory_order_relaxed) == data ||
+                 bucket(false, right).load(std::memory_order_relaxed) == data ||
+                 stash_holds(data);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (version_left.load(std::memory_order_relaxed) == before_left &&
+        version_right.load(std::memory_order_relaxed) == before_right &&
+        version_stash.load(std::memory_order_relaxed) == before_stash) {
+      return found;
+    }
+  }
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentCuckooHashTable<Hash, Capacity>::insert(int data)
+{
+  PathStep search[kSearchSize];
+  bool use_stash = false; // set once there is no eviction path for data
+  ReaderGuard reader(*this);
+  for (;;) {
+    const Functions* functions = reader.protect();
+    size_t left = this->capacity.index(functions->left(data));
+    size_t right = this->capacity.index(functions->right(data));
+    size_t stripe_left = stripe_for(true, left);
+    size_t stripe_right = stripe_for(false, right);
+
+    lock_pair(stripe_left, stripe_right);
+    if (use_stash) lock(kStashStripe);
+
+    // data only enters or leaves the stash with both of its stripes locked
+    std::atomic<int>& bucket_left = bucket(true, left);
+    std::atomic<int>& bucket_right = bucket(false, right);
+    bool current = this->functions.load(std::memory_order_relaxed) == functions;
+    bool done = true;
+    if (!current) {
+      done = false; // rehashed meanwhile
+    } else if (bucket_left.load(std::memory_order_relaxed) == data ||
+               bucket_right.load(std::memory_order_relaxed) == data || stash_holds(data)) {
+      // found data; don't insert duplicate
+    } else if (bucket_left.load(std::memory_order_relaxed) == EMPTY) {
+      bucket_left.store(data, std::memory_order_relaxed);
+    } else if (bucket_right.load(std::memory_order_relaxed) == EMPTY) {
+      bucket_right.store(data, std::memory_order_relaxed);
+    } else if (use_stash && this->stash_size.load(std::memory_order_relaxed) < kStashSize) {
+      for (auto& slot : this->stash) {
+        if (slot.load(std::memory_order_relaxed) == EMPTY) {
+          slot.store(data, std::memory_order_relaxed);
+          break;
+        }
+      }
+      this->stash_size.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      done = false;
+    }
+
+    if (use_stash) unlock(kStashStripe);
+    unlock_pair(stripe_left, stripe_right);
+    if (done) return;
+
+    if (!current) {
+      use_stash = false;
+    } else if (use_stash) {
+      rehash(functions); // the stash is full
+      use_stash = false;
+    } else {
+      // both buckets taken; free one up and try again, or fall back to the stash
+      size_t at = find_path(functions, data, search);
+      if (at != kNoParent) {
+        shift_along(functions, search, at);
+      } else {
+        use_stash = true;
+      }
+    }
+  }
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentCuckooHashTable<Hash, Capacity>::remove(int data)
+{
+  ReaderGuard reader(*this);
+  for (;;) {
+    const Functions* functions = reader.protect();
+    size_t left = this->capacity.index(functions->left(data));
+    size_t right = this->capacity.index(functions->right(data));
+    size_t stripe_left = stripe_for(true, left);
+    size_t stripe_right = stripe_for(false, right);
+
+    lock_pair(stripe_left, stripe_right);
+    bool current = this->functions.load(std::memory_order_relaxed) == functions;
+    if (current) {
+      for (std::atomic<int>* slot : {&bucket(true, left), &bucket(false, right)}) {
+        if (slot->load(std::memory_order_relaxed) == data) slot->store(EMPTY, std::memory_order_relaxed);
+      }
+      if (stash_holds(data)) {
+        lock(kStashStripe);
+        for (auto& slot : this->stash) {
+          if (slot.load(std::memory_order_relaxed) == data) slot.store(EMPTY, std::memory_order_relaxed);
+        }
+        this->stash_size.fetch_sub(1, std::memory_order_relaxed);
+        unlock(kStashStripe);
+      }
+    }
+    unlock_pair(stripe_left, stripe_right);
+    if (current) return;
+  }
+}
+
+template <typename Hash, typename Capacity>
+size_t BasicConcurrentCuckooHashTable<Hash, Capacity>::find_path(const Functions* functions, int data, PathStep* search) const
+{
+  /* As in CuckooHashTable::insert_along_path, the two eviction chains are
+   * followed in lock-step, so search[head] is head / 2 moves away.
+   */
+  search[0] = PathStep{true, this->capacity.index(functions->left(data)), kNoParent, EMPTY};
+  search[1] = PathStep{false, this->capacity.index(functions->right(data)), kNoParent, EMPTY};
+  size_t size = 2;
+
+  for (size_t head = 0; head < size; head++) {
+    PathStep& step = search[head];
+    step.key = bucket(step.left, step.index).load(std::memory_order_relaxed);
+    if (step.key == EMPTY) return head;
+
+    if (head / 2 < kMaxPathLength) {
+      size_t next = step.left ? this->capacity.index(functions->right(step.key))
+                              : this->capacity.index(functions->left(step.key));
+      search[size++] = PathStep{!step.left, next, head, EMPTY};
+    }
+  }
+  return kNoParent;
+}
+
+template <typename Hash, typename Capacity>
+bool BasicConcurrentCuckooHashTable<Hash, Capacity>::shift_along(const Functions* functions, const PathStep* search, size_t at)
+{
+  for (; search[at].parent != kNoParent; at = search[at].parent) {
+    const PathStep& to = search[at];
+    const PathStep& from = search[to.parent];
+    size_t stripe_from = stripe_for(from.left, from.index);
+    size_t stripe_to = stripe_for(to.left, to.index);
+
+    // these are the two buckets of from.key, so they're all its readers look at
+    lock_pair(stripe_from, stripe_to);
+    bool unchanged = this->functions.load(std::memory_order_relaxed) == functions &&
+                     bucket(from.left, from.index).load(std::memory_order_relaxed) == from.key &&
+                     bucket(to.left, to.index).load(std::memory_order_relaxed) == EMPTY;
+    if (unchanged) {
+      bucket(to.left, to.index).store(from.key, std::memory_order_relaxed);
+      bucket(from.left, from.index).store(EMPTY, std::memory_order_relaxed);
+    }
+    unlock_pair(stripe_from, stripe_to);
+    if (!unchanged) return false;
+  }
+  return true;
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentCuckooHashTable<Hash, Capacity>::rehash(const Functions* seen)
+{
+  for (size_t stripe = 0; stripe <= kStripes; stripe++) lock(stripe);
+
+  if (this->functions.load(std::memory_order_relaxed) == seen) {
+    std::vector<int> elements;
+    for (size_t index = 0; index < this->capacity.size(); index++) {
+      for (bool left : {true, false}) {
+        int data = bucket(left, index).load(std::memory_order_relaxed);
+        if (data != EMPTY) elements.push_back(data);
+      }
+    }
+    for (auto& slot : this->stash) {
+      int data = slot.load(std::memory_order_relaxed);
+      if (data != EMPTY) elements.push_back(data);
+    }
+
+    // readers never see a pair until it is published, so it can be redrawn
+    std::unique_ptr<Functions> candidate(new Functions);
+    bool success = false;
+    while (!success) {
+      candidate->left = sampleHash<Hash>(this->hash_family);
+      candidate->right = sampleHash<Hash>(this->hash_family);
+      for (size_t index = 0; index < this->capacity.size(); index++) {
+        bucket(true, index).store(EMPTY, std::memory_order_relaxed);
+        bucket(false, index).store(EMPTY, std::memory_order_relaxed);
+      }
+      for (auto& slot : this->stash) slot.store(EMPTY, std::memory_order_relaxed);
+      this->stash_size.store(0, std::memory_order_relaxed);
+
+      success = true;
+      for (int data : elements) {
+        success = place_locked(candidate.get(), data);
+        if (!success) break;
+      }
+    }
+    /* Sequentially consistent, which includes release for the readers that
+     * acquire the pointer: an operation either announced an old pair before
+     * this store, and the scan below sees it, or it will find the pointer
+     * changed when it checks and announce the new pair instead.
+     */
+    this->functions.store(candidate.get(), std::memory_order_seq_cst);
+    this->generations.push_back(std::move(candidate));
+
+    const Functions* current = this->generations.back().get();
+    auto unused = [&](const std::unique_ptr<Functions>& generation) {
+      if (generation.get() == current) return false;
+      for (size_t reader = 0; reader < kReaders; reader++) {
+        if (this->readers[reader].functions.load(std::memory_order_seq_cst) == generation.get()) return false;
+      }
+      return true;
+    };
+    this->generations.erase(std::remove_if(this->generations.begin(), this->generations.end(), unused),
+                            this->generations.end());
+  }
+
+  for (size_t stripe = 0; stripe <= kStripes; stripe++) unlock(stripe);
+}
+
+template <typename Hash, typename Capacity>
+bool BasicConcurrentCuckooHashTable<Hash, Capacity>::place_locked(const Functions* functions, int data)
+{
+  bool left = true;
+  for (size_t displacements = 0; displacements <= kMaxDisplacements; displacements++) {
+    size_t index = left ? this->capacity.index(functions->left(data))
+                        : this->capacity.index(functions->right(data));
+    data = bucket(left, index).exchange(data, std::memory_order_relaxed);
+    if (data == EMPTY) return true;
+    left = !left;
+  }
+
+  size_t size = this->stash_size.load(std::memory_order_relaxed);
+  if (size == kStashSize) return false;
+  this->stash[size].store(data, std::memory_order_relaxed); // packed while rehashing
+  this->stash_size.store(size + 1, std::memory_order_relaxed);
+  return true;
+}
+
+/* Helpers */
+
+template <typename Hash, typename Capacity>
+inline std::atomic<int>& BasicConcurrentCuckooHashTable<Hash, Capacity>::bucket(bool left, size_t index) const
+{
+  return left ? this->buckets_left[index] : this->buckets_right[index];
+}
+
+template <typename Hash, typename Capacity>
+inline bool BasicConcurrentCuckooHashTable<Hash, Capacity>::stash_holds(int data) const
+{
+  if (this->stash_size.load(std::memory_order_relaxed) == 0) return false;
+  for (const auto& slot : this->stash) {
+    if (slot.load(std::memory_order_relaxed) == data) return true;
+  }
+  return false;
+}
+
+template <typename Hash, typename Capacity>
+inline size_t BasicConcurrentCuckooHashTable<Hash, Capacity>::stripe_for(bool left, size_t index) const
+{
+  return (2 * index + left) & (kStripes - 1);
+}
+
+/**
+ * Claims a free reader slot, starting from one picked by the thread's id so
+ * that threads rarely compete for the same slot. With every slot taken, it
+ * waits for one to come free.
+ */
+template <typename Hash, typename Capacity>
+BasicConcurrentCuckooHashTable<Hash, Capacity>::ReaderGuard::ReaderGuard(const BasicConcurrentCuckooHashTable& table)
+  : table(table), slot(nullptr)
+{
+  // thread ids tend to share their low bits, so mix them into the high ones
+  size_t start = size_t((uint64_t(std::hash<std::thread::id>()(std::this_thread::get_id())) *
+                         0x9E3779B97F4A7C15ull) >> 32);
+  for (size_t attempt = 0; ; attempt++) {
+    auto& candidate = table.readers[(start + attempt) % kReaders].functions;
+    const Functions* expected = nullptr;
+    const Functions* current = table.functions.load(std::memory_order_acquire);
+    if (candidate.compare_exchange_strong(expected, current, std::memory_order_seq_cst)) {
+      this->slot = &candidate;
+      return;
+    }
+    if (attempt % kReaders == kReaders - 1) std::this_thread::yield();
+  }
+}
+
+template <typename Hash, typename Capacity>
+BasicConcurrentCuckooHashTable<Hash, Capacity>::ReaderGuard::~ReaderGuard()
+{
+  this->slot->store(nullptr, std::memory_order_release);
+}
+
+template <typename Hash, typename Capacity>
+auto BasicConcurrentCuckooHashTable<Hash, Capacity>::ReaderGuard::protect() -> const Functions*
+{
+  const Functions* functions = this->table.functions.load(std::memory_order_seq_cst);
+  for (;;) {
+    this->slot->store(functions, std::memory_order_seq_cst);
+    // if no rehash published a new pair meanwhile, the next one will see ours
+    const Functions* current = this->table.functions.load(std::memory_order_seq_cst);
+    if (current == functions) return functions;
+    functions = current;
+  }
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentCuckooHashTable<Hash, Capacity>::lock(size_t stripe)
+{
+  std::atomic<uint32_t>& version = this->stripes[stripe].version;
+  for (;;) {
+    uint32_t current = version.load(std::memory_order_relaxed);
+    if (!(current & 1) &&
+        version.compare_exchange_weak(current, current + 1, std::memory_order_acquire)) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+  // keep our writes from becoming visible before the odd version
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentCuckooHashTable<Hash, Capacity>::unlock(size_t stripe)
+{
+  this->stripes[stripe].version.fetch_add(1, std::memory_order_release);
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentCuckooHashTable<Hash, Capacity>::lock_pair(size_t first, size_t second)
+{
+  if (first > second) std::swap(first, second);
+  lock(first);
+  if (second != first) lock(second);
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentCuckooHashTable<Hash, Capacity>::unlock_pair(size_t first, size_t second)
+{
+  unlock(first);
+  if (second != first) unlock(second);
+}
+
+#define INSTANTIATE(Hash, Capacity) template class BasicConcurrentCuckooHashTable<Hash, Capacity>;
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
@@ -0,0 +1,189 @@
+#ifndef ConcurrentCuckooHashTable_Included
+#define ConcurrentCuckooHashTable_Included
+
+#include "Hashes.h"
+#include "Capacity.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * A cuckoo hash table that any number of threads can use at once, built for
+ * read-heavy workloads. A lookup only ever looks at two buckets, so readers
+ * take no lock at all; they validate what they read against version
+ * counters instead, like readers of a seqlock.
+ *
+ * The buckets are covered by kStripes lock stripes, each a version counter
+ * that is odd while a writer holds it. A reader notes the versions of the
+ * stripes of its two buckets, reads the buckets, and retries if either
+ * version changed in between. Writers lock the stripes of the two buckets
+ * they change, in increasing order:
+ *
+ *  - insert and remove lock the stripes of the key's two buckets;
+ *  - an insertion that finds both buckets full first searches, without
+ *    locks, for a path of evictions ending in an empty bucket, as
+ *    BreadthFirstInsertion does in CuckooHashTable. It then shifts the keys
+ *    along it starting from the empty end. Each move locks the two buckets
+ *    of the key being moved, and checks that nothing changed since the
+ *    search; otherwise the insertion starts over.
+ *
+ * If no path is found, the key goes into a stash of kStashSize keys, as in
+ * CuckooHashTable, which has a stripe of its own. Lookups that miss both
+ * buckets check the stash as well. Only once the stash is full is the
+ * table rehashed, with all stripes locked.
+ *
+ * Hash functions are replaced, never modified, so that readers still hashing
+ * with the old ones can't see a torn hash function. Every operation announces
+ * the pair it hashes with in one of kReaders slots, like a hazard pointer,
+ * and a rehash frees every old pair that no slot announces. So besides the
+ * current pair, at most one old pair per running operation is kept.
+ *
+ * Like CuckooHashTable, -1 marks an empty bucket and can't be stored.
+ */
+template <typename Hash, typename Capacity = ModuloCapacity>
+class BasicConcurrentCuckooHashTable {
+public:
+  /**
+   * Constructs a new concurrent cuckoo hash table with the specified number
+   * of buckets, split over two tables, using hash functions drawn from the
+   * indicated family. The table never changes its size.
+   */
+  BasicConcurrentCuckooHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+
+  /**
+   * Cleans up all memory allocated by this hash table.
+   */
+  ~BasicConcurrentCuckooHashTable();
+
+  /**
+   * Inserts the specified element into this hash table. If the element already
+   * exists, this operation is a no-op.
+   */
+  void insert(int key);
+
+  /**
+   * Returns whether the specified key is contained in this hash table. Never
+   * blocks a writer.
+   */
+  bool contains(int key) const;
+
+  /**
+   * Removes the specified element from this hash table. If the element is not
+   * present in the hash table, this operation is a no-op.
+   */
+  void remove(int key);
+
+  static const size_t kStripes = 1024;
+  static const size_t kReaders = 64;
+  static const size_t kMaxPathLength = 64;
+  static const size_t kStashSize = 4;
+
+private:
+  /* One pair of hash functions. Replaced as a whole on every rehash. */
+  struct Functions {
+    Hash left;
+    Hash right;
+  };
+
+  /* A stripe per cache line, so that writers on different stripes don't
+   * invalidate each other's versions.
+   */
+  struct Stripe {
+    std::atomic<uint32_t> version;
+    char padding[64 - sizeof(std::atomic<uint32_t>)];
+  };
+
+  /* A bucket visited by the search, as in CuckooHashTable, plus the key
+   * the search saw in it.
+   */
+  struct PathStep {
+    bool left;
+    size_t index;
+    size_t parent;
+    int key;
+  };
+  static const size_t kNoParent = size_t(-1);
+  static const size_t kSearchSize = 2 * (kMaxPathLength + 1);
+
+  static const size_t kStashStripe = kStripes; // locked after all others
+
+  /* A slot in which an operation announces the hash functions it is using,
+   * or nullptr if the slot is free. One per cache line, as for stripes.
+   */
+  struct Reader {
+    std::atomic<const Functions*> functions;
+    char padding[64 - sizeof(std::atomic<const Functions*>)];
+  };
+
+  /* Holds a reader slot for as long as an operation runs. */
+  class ReaderGuard {
+  public:
+    explicit ReaderGuard(const BasicConcurrentCuckooHashTable& table);
+    ~ReaderGuard();
+
+    /* Announces the current hash functions and returns them; they stay
+     * allocated until the next call, or until the guard goes away.
+     */
+    const Functions* protect();
+
+  private:
+    const BasicConcurrentCuckooHashTable& table;
+    std::atomic<const Functions*>* slot;
+  };
+
+  std::atomic<int>& bucket(bool left, size_t index) const;
+  bool stash_holds(int key) const;
+  size_t stripe_for(bool left, size_t index) const;
+
+  void lock(size_t stripe);
+  void unlock(size_t stripe);
+  void lock_pair(size_t first, size_t second);
+  void unlock_pair(size_t first, size_t second);
+
+  /* Searches both eviction chains starting at key's buckets for an empty
+   * bucket, without locking. Fills 'search' (kSearchSize steps) and returns
+   * the step of the empty bucket, or kNoParent if none is close enough.
+   */
+  size_t find_path(const Functions* functions, int key, PathStep* search) const;
+
+  /* Moves the keys on the path ending at search[at] one step on, starting
+   * from the empty end. Returns false if another writer got in the way.
+   */
+  bool shift_along(const Functions* functions, const PathStep* search, size_t at);
+
+  /* Draws new hash functions and reinserts every element, unless someone
+   * else did so since 'seen' was current. Runs with every stripe locked.
+   */
+  void rehash(const Functions* seen);
+
+  /* Places key by a random walk of evictions while rehashing, or in the
+   * stash if that takes too long. Returns false if the stash is full.
+   */
+  bool place_locked(const Functions* functions, int key);
+
+  std::shared_ptr<HashFamily> hash_family;
+  std::atomic<const Functions*> functions;
+  std::vector<std::unique_ptr<Functions>> generations; // the current pair and those still in use
+  std::unique_ptr<Reader[]> readers;
+  std::unique_ptr<std::atomic<int>[]> buckets_left;
+  std::unique_ptr<std::atomic<int>[]> buckets_right;
+  std::unique_ptr<Stripe[]> stripes;
+  std::atomic<int> stash[kStashSize];
+  std::atomic<size_t> stash_size;
+  Capacity capacity;
+
+  /* Fun with C++: these next two lines disable implicitly-generated copy
+   * functions that would otherwise cause weird errors if you tried to
+   * implicitly copy an object of this type. You don't need to touch these
+   * lines.
+   */
+  BasicConcurrentCuckooHashTable(BasicConcurrentCuckooHashTable const &) = delete;
+  void operator=(BasicConcurrentCuckooHashTable const &) = delete;
+};
+
+/* The type-erased table, usable with every hash family. */
+using ConcurrentCuckooHashTable = BasicConcurrentCuckooHashTable<HashFunction>;
+
+#endif
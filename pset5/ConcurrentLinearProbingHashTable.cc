@@ -0,0 +1,153 @@
+#include "ConcurrentLinearProbingHashTable.h"
+
+#include <stdexcept>
+#include <thread>
+
+static const size_t npos = size_t(-1);
+
+template <typename Hash, typename Capacity>
+BasicConcurrentLinearProbingHashTable<Hash, Capacity>::BasicConcurrentLinearProbingHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
+{
+  this->hashFunction = sampleHash<Hash>(family);
+  this->capacity = Capacity(numBuckets);
+  this->buckets.reset(new std::atomic<Slot>[this->capacity.size()]);
+  for (size_t index = 0; index < this->capacity.size(); index++) {
+    this->buckets[index].store(make_slot(0, kEmpty), std::memory_order_relaxed);
+  }
+}
+
+template <typename Hash, typename Capacity>
+BasicConcurrentLinearProbingHashTable<Hash, Capacity>::~BasicConcurrentLinearProbingHashTable()
+{
+  // unique_ptr cleans up after itself
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentLinearProbingHashTable<Hash, Capacity>::insert(int data)
+{
+  for (;;) {
+    // find the first bucket we could take, unless data is already live
+    size_t free = npos;
+    Slot slot = 0;
+    size_t index = this->index_for_data(data);
+    for (size_t probes = 0; probes < this->capacity.size(); probes++) {
+      Slot current = this->buckets[index].load(std::memory_order_acquire);
+      if (current == make_slot(data, kLive)) return;
+      if (free == npos && (state_of(current) == kEmpty || state_of(current) == kDeleted)) {
+        free = index; // but keep looking for data past tombstones
+        slot = current;
+      }
+      if (state_of(current) == kEmpty) break;
+      index = this->capacity.next(index);
+    }
+    if (free == npos) {
+      throw std::length_error("ConcurrentLinearProbingHashTable: every bucket holds a key");
+    }
+    index = free;
+
+    // claim it; if another thread got there first, start over. Sequentially
+    // consistent, like the scan in other_copy: of two threads claiming
+    // buckets for the same key, at least one must see the other's claim.
+    if (!this->buckets[index].compare_exchange_strong(slot, make_slot(data, kPending),
+                                                      std::memory_order_seq_cst)) {
+      continue;
+    }
+    size_t copy = other_copy(data, index);
+    if (copy == npos) {
+      this->buckets[index].store(make_slot(data, kLive), std::memory_order_release);
+      return;
+    }
+
+    // give way: hand the bucket back, let the other copy settle, and retry
+    this->buckets[index].store(make_slot(data, kDeleted), std::memory_order_release);
+    while (this->buckets[copy].load(std::memory_order_acquire) == make_slot(data, kPending)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+template <typename Hash, typename Capacity>
+size_t BasicConcurrentLinearProbingHashTable<Hash, Capacity>::other_copy(int data, size_t mine) const
+{
+  bool past_mine = false;
+  size_t index = this->index_for_data(data);
+  for (size_t probes = 0; probes < this->capacity.size(); probes++) {
+    if (index == mine) {
+      past_mine = true;
+    } else {
+      Slot slot = this->buckets[index].load(std::memory_order_seq_cst);
+      if (state_of(slot) == kEmpty) return npos;
+      // a pending copy farther out gives way once it sees ours, or goes live
+      while (past_mine && slot == make_slot(data, kPending)) {
+        std::this_thread::yield();
+        slot = this->buckets[index].load(std::memory_order_acquire);
+      }
+      if (slot == make_slot(data, kLive) || slot == make_slot(data, kPending)) return index;
+    }
+    index = this->capacity.next(index);
+  }
+  return npos;
+}
+
+template <typename Hash, typename Capacity>
+bool BasicConcurrentLinearProbingHashTable<Hash, Capacity>::contains(int data) const
+{
+  size_t index = this->index_for_data(data);
+  for (size_t probes = 0; probes < this->capacity.size(); probes++) {
+    Slot slot = this->buckets[index].load(std::memory_order_acquire);
+    if (state_of(slot) == kEmpty) return false;
+    if (key_of(slot) == data && state_of(slot) == kLive) return true;
+    index = this->capacity.next(index); // past tombstones, ours included
+  }
+  return false;
+}
+
+template <typename Hash, typename Capacity>
+void BasicConcurrentLinearProbingHashTable<Hash, Capacity>::remove(int data)
+{
+  size_t index = this->index_for_data(data);
+  for (size_t probes = 0; probes < this->capacity.size(); probes++) {
+    Slot slot = this->buckets[index].load(std::memory_order_acquire);
+    if (state_of(slot) == kEmpty) return;
+    if (key_of(slot) == data && state_of(slot) == kLive) {
+      // a failed CAS means it was removed already
+      this->buckets[index].compare_exchange_strong(slot, make_slot(data, kDeleted),
+                                                   std::memory_order_acq_rel);
+      return;
+    }
+    index = this->capacity.next(index);
+  }
+}
+
+template <typename Hash, typename Capacity>
+size_t BasicConcurrentLinearProbingHashTable<Hash, Capacity>::index_for_data(int data) const
+{
+  size_t hash_value = this->hashFunction(data);
+  size_t index = this->capacity.index(hash_value);
+  return index;
+}
+
+/* Helpers */
+
+template <typename Hash, typename Capacity>
+inline typename BasicConcurrentLinearProbingHashTable<Hash, Capacity>::Slot
+BasicConcurrentLinearProbingHashTable<Hash, Capacity>::make_slot(int key, uint32_t state)
+{
+  return Slot(uint32_t(key)) << 32 | state;
+}
+
+template <typename Hash, typename Capacity>
+inline int BasicConcurrentLinearProbingHashTable<Hash, Capacity>::key_of(Slot slot)
+{
+  return int(uint32_t(slot >> 32));
+}
+
+template <typename Hash, typename Capacity>
+inline uint32_t BasicConcurrentLinearProbingHashTable<Hash, Capacity>::state_of(Slot slot)
+{
+  return uint32_t(slot);
+}
+
+#define INSTANTIATE(Hash, Capacity) template class BasicConcurrentLinearProbingHashTable<Hash, Capacity>;
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
@@ -0,0 +1,101 @@
+#ifndef ConcurrentLinearProbingHashTable_Included
+#define ConcurrentLinearProbingHashTable_Included
+
+#include "Hashes.h"
+#include "Capacity.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/**
+ * A linear probing set that any number of threads can use at once without a
+ * lock. Every bucket is a single 64-bit atomic holding a key together with
+ * its state. contains only loads, and remove marks the key's bucket deleted
+ * with one compare-and-swap, leaving a tombstone.
+ *
+ * insert reuses the first tombstone or empty bucket on the key's probe path.
+ * It claims the bucket as pending, then scans the key's whole cluster for
+ * another copy of the key before it makes its own live. If it finds a live
+ * copy, or a pending one closer to home, it gives the bucket back as a
+ * tombstone, waits for that copy to settle and starts over; a pending copy
+ * farther from home it waits for, since that insertion will see this one
+ * and give way. So a key is never live in two buckets, and since buckets
+ * never become empty again, no lookup can miss a key that another thread is
+ * inserting or removing concurrently. Only those waits for an insertion of
+ * the same key are not lock-free.
+ *
+ * Every int can be stored; no key value is reserved as a sentinel.
+ *
+ * The table is templated on its hash function and Capacity policy, just like
+ * LinearProbingHashTable.
+ */
+template <typename Hash, typename Capacity = ModuloCapacity>
+class BasicConcurrentLinearProbingHashTable {
+public:
+  /**
+   * Constructs a new concurrent linear probing table with the specified
+   * number of buckets, using a hash function drawn from the indicated family.
+   * The table never changes its size.
+   */
+  BasicConcurrentLinearProbingHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+
+  /**
+   * Cleans up all memory allocated by this hash table.
+   */
+  ~BasicConcurrentLinearProbingHashTable();
+
+  /**
+   * Inserts the specified element into this hash table. If the element already
+   * exists, this operation is a no-op. Throws std::length_error if every
+   * bucket holds another key.
+   */
+  void insert(int key);
+
+  /**
+   * Returns whether the specified key is contained in this hash table.
+   */
+  bool contains(int key) const;
+
+  /**
+   * Removes the specified element from this hash table. If the element is not
+   * present in the hash table, this operation is a no-op.
+   */
+  void remove(int key);
+
+  size_t index_for_data(int data) const;
+
+private:
+  /* The key sits in the upper 32 bits and its state in the lower ones, so
+   * a bucket is never torn between a key and its state.
+   */
+  typedef uint64_t Slot;
+  enum : uint32_t { kEmpty = 0, kLive = 1, kDeleted = 2, kPending = 3 };
+
+  /* Scans data's cluster for a copy of data other than the one pending at
+   * 'mine' that insert has to give way to: a live one, or a pending one
+   * closer to home. Returns its bucket, or npos if there is none.
+   */
+  size_t other_copy(int data, size_t mine) const;
+
+  static Slot make_slot(int key, uint32_t state);
+  static int key_of(Slot slot);
+  static uint32_t state_of(Slot slot);
+
+  std::unique_ptr<std::atomic<Slot>[]> buckets;
+  Capacity capacity;
+  Hash hashFunction;
+
+  /* Fun with C++: these next two lines disable implicitly-generated copy
+   * functions that would otherwise cause weird errors if you tried to
+   * implicitly copy an object of this type. You don't need to touch these
+   * lines.
+   */
+  BasicConcurrentLinearProbingHashTable(BasicConcurrentLinearProbingHashTable const &) = delete;
+  void operator=(BasicConcurrentLinearProbingHashTable const &) = delete;
+};
+
+/* The type-erased table, usable with every hash family. */
+using ConcurrentLinearProbingHashTable = BasicConcurrentLinearProbingHashTable<HashFunction>;
+
+#endif
@@ -1,145 +1,315 @@
 #include "CuckooHashTable.h"
 
+#include <algorithm>
+
+static const int EMPTY = -1;
+
 constexpr size_t log2(size_t n);
-constexpr size_t log2(size_t n) 
+constexpr size_t log2(size_t n)
 {
   return (n > 1) ? 1 + log2(n >> 1) : 0;
 }
 
-CuckooHashTable::CuckooHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
+template <typename Hash, typename Capacity, typename Insertion>
+BasicCuckooHashTable<Hash, Capacity, Insertion>::BasicCuckooHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
 {
   this->hash_family = family;
+  this->number_of_rehashes = 0;
+  this->stash_hits = 0;
   init(numBuckets / 2);
 
 }
 
-void CuckooHashTable::init(int number_of_buckets)
+template <typename Hash, typename Capacity, typename Insertion>
+void BasicCuckooHashTable<Hash, Capacity, Insertion>::init(size_t number_of_buckets)
 {
-  this->number_of_buckets = number_of_buckets;
-  this->buckets_left  = std::vector<std::pair<int, size_t>>(this->number_of_buckets, std::pair<int, size_t>(-1, 0));
-  this->buckets_right = std::vector<std::pair<int, size_t>>(this->number_of_buckets, std::pair<int, size_t>(-1, 0));
+  this->capacity = Capacity(number_of_buckets);
+  this->number_of_buckets = this->capacity.size();
+  this->buckets_left  = std::vector<int>(this->number_of_buckets, EMPTY);
+  this->buckets_right = std::vector<int>(this->number_of_buckets, EMPTY);
 
-  this->hash_function_left  = this->hash_family->get();
-  this->hash_function_right = this->hash_family->get();
+  this->hash_function_left  = sampleHash<Hash>(this->hash_family);
+  this->hash_function_right = sampleHash<Hash>(this->hash_family);
 
+  this->stash_size = 0;
   this->insert_in_left = false;
-  this->is_rehashing = false;
   this->number_of_elements = 0;
-  this->rehash_threshold = 5;
+  update_rehash_threshold();
 }
 
-CuckooHashTable::~CuckooHashTable()
+template <typename Hash, typename Capacity, typename Insertion>
+BasicCuckooHashTable<Hash, Capacity, Insertion>::~BasicCuckooHashTable()
 {
   // TODO: Implement this
 }
 
-void CuckooHashTable::insert(int data)
+template <typename Hash, typename Capacity, typename Insertion>
+void BasicCuckooHashTable<Hash, Capacity, Insertion>::insert(int data)
 {
-  this->insert_in(std::pair<int, size_t>(data, 0));
+  // not contains(): a duplicate found in the stash isn't a query's stash hit
+  if (stored_at(data, indices_for_data(data))) return;
+  if (!place(data)) rehash(data);
 }
 
-bool CuckooHashTable::insert_in(std::pair<int, size_t> data)
+template <typename Hash, typename Capacity, typename Insertion>
+bool BasicCuckooHashTable<Hash, Capacity, Insertion>::place(int& data)
 {
-  if (this->contains(data.first)) return true;
+  bool placed = Insertion::kBreadthFirst ? insert_along_path(data) : insert_in(data);
+  if (!placed) {
+    if (this->stash_size == kStashSize) return false; // stash overflows
+    this->stash[this->stash_size++] = data;
+  }
+  this->number_of_elements++;
+  update_rehash_threshold();
+  return true;
+}
 
+template <typename Hash, typename Capacity, typename Insertion>
+bool BasicCuckooHashTable<Hash, Capacity, Insertion>::insert_in(int& data)
+{
   this->insert_in_left = !this->insert_in_left;
-  if (data.second > this->rehash_threshold) {
-    if (this->is_rehashing) {
-      return false; // abort and start new rehashing
+  bool left = this->insert_in_left;
+
+  for (size_t displacements = 0; ; displacements++) {
+    std::pair<size_t, size_t> indices = indices_for_data(data);
+    if (left) {
+      std::swap(data, this->buckets_left[indices.first]);
     } else {
-      rehash();
+      std::swap(data, this->buckets_right[indices.second]);
     }
+    if (data == EMPTY) return true; // success
+
+    // displaced an element; it moves to its bucket on the other side
+    if (displacements >= this->rehash_threshold) return false;
+    left = !left;
   }
+}
 
-  std::pair<size_t, size_t> indices = indices_for_data(data.first);
-  if (this->insert_in_left) {
-
-    size_t index = indices.first;
-    if (! this->buckets_left[index].first) {
-      this->buckets_left[index] = data;
-    } else { // displace
-      auto displaced_data = this->buckets_left[index];
-      this->buckets_left[index] = data;
-      displaced_data.second++;
-      insert_in(displaced_data);
-    }
+template <typename Hash, typename Capacity, typename Insertion>
+bool BasicCuckooHashTable<Hash, Capacity, Insertion>::insert_along_path(int data)
+{
+  /* Every occupied bucket has exactly one successor: the other bucket of its
+   * occupant. The search therefore follows the two eviction chains starting
+   * at data's buckets in lock-step, and 'search' stays short.
+   */
+  std::pair<size_t, size_t> indices = indices_for_data(data);
+  this->search.clear();
+  this->search.push_back(PathStep{true, indices.first, kNoParent, 0});
+  this->search.push_back(PathStep{false, indices.second, kNoParent, 0});
 
-  } else {
+  for (size_t head = 0; head < this->search.size(); head++) {
+    PathStep step = this->search[head];
+    int occupant = step.left ? this->buckets_left[step.index] : this->buckets_right[step.index];
 
-    size_t index = indices.second;
-    if (! this->buckets_right[index].first) {
-      this->buckets_right[index] = data;
-    } else { // displace
-      auto displaced_data = this->buckets_right[index];
-      this->buckets_right[index] = data;
-      displaced_data.second++;
-      insert_in(displaced_data);
+    if (occupant == EMPTY) {
+      // found a free bucket; move every occupant along the path one step on
+      for (size_t at = head; at != kNoParent; at = this->search[at].parent) {
+        const PathStep& to = this->search[at];
+        int moving = data;
+        if (to.parent != kNoParent) {
+          const PathStep& from = this->search[to.parent];
+          moving = from.left ? this->buckets_left[from.index] : this->buckets_right[from.index];
+        }
+        (to.left ? this->buckets_left[to.index] : this->buckets_right[to.index]) = moving;
+      }
+      return true;
     }
 
+    if (step.depth < this->rehash_threshold) {
+      std::pair<size_t, size_t> next = indices_for_data(occupant);
+      this->search.push_back(PathStep{!step.left, step.left ? next.second : next.first, head, step.depth + 1});
+    }
   }
-  this->number_of_elements++;
-  this->rehash_threshold = 6 * log2(number_of_elements);
-  return true; // success
+  return false;
 }
 
-bool CuckooHashTable::contains(int data) const
+template <typename Hash, typename Capacity, typename Insertion>
+bool BasicCuckooHashTable<Hash, Capacity, Insertion>::contains(int data) const
 {
-  size_t index_left, index_right;
-  std::tie(index_left, index_right) = indices_for_data(data);
-  return this->buckets_left[index_left].first == data ||
-         this->buckets_right[index_right].first == data;
+  return contains_at(data, indices_for_data(data));
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+bool BasicCuckooHashTable<Hash, Capacity, Insertion>::contains_at(int data, std::pair<size_t, size_t> indices) const
+{
+  if (this->buckets_left[indices.first] == data ||
+      this->buckets_right[indices.second] == data) {
+    return true;
+  }
+  if (!in_stash(data)) return false;
+  this->stash_hits++;
+  return true;
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+bool BasicCuckooHashTable<Hash, Capacity, Insertion>::stored_at(int data, std::pair<size_t, size_t> indices) const
+{
+  return this->buckets_left[indices.first] == data ||
+         this->buckets_right[indices.second] == data ||
+         in_stash(data);
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+bool BasicCuckooHashTable<Hash, Capacity, Insertion>::in_stash(int data) const
+{
+  for (size_t i = 0; i < this->stash_size; i++) {
+    if (this->stash[i] == data) return true;
+  }
+  return false;
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+void BasicCuckooHashTable<Hash, Capacity, Insertion>::contains_many(const int* keys, size_t n, bool* out) const
+{
+  size_t hashes1[kBatchSize];
+  size_t hashes2[kBatchSize];
+  std::pair<size_t, size_t> indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hash_function_left, keys + start, count, hashes1);
+    hashMany(this->hash_function_right, keys + start, count, hashes2);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = std::make_pair(this->capacity.index(hashes1[i]), this->capacity.index(hashes2[i]));
+      prefetch(&this->buckets_left[indices[i].first]);
+      prefetch(&this->buckets_right[indices[i].second]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      out[start + i] = contains_at(keys[start + i], indices[i]);
+    }
+  }
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+void BasicCuckooHashTable<Hash, Capacity, Insertion>::insert_many(const int* keys, size_t n)
+{
+  size_t hashes1[kBatchSize];
+  size_t hashes2[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hash_function_left, keys + start, count, hashes1);
+    hashMany(this->hash_function_right, keys + start, count, hashes2);
+    for (size_t i = 0; i < count; i++) {
+      prefetch(&this->buckets_left[this->capacity.index(hashes1[i])]);
+      prefetch(&this->buckets_right[this->capacity.index(hashes2[i])]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      insert(keys[start + i]);
+    }
+  }
 }
 
-void CuckooHashTable::remove(int data)
+template <typename Hash, typename Capacity, typename Insertion>
+void BasicCuckooHashTable<Hash, Capacity, Insertion>::remove(int data)
 {
   size_t index_left, index_right;
   std::tie(index_left, index_right) = indices_for_data(data);
-  if (this->buckets_left[index_left].first == data) {
-    this->buckets_left[index_left] = std::pair<int, size_t>(-1, 0);
+  if (this->buckets_left[index_left] == data) {
+    this->buckets_left[index_left] = EMPTY;
     this->number_of_elements--;
-  } else if (this->buckets_right[index_right].first == data) {
-    this->buckets_right[index_right] = std::pair<int, size_t>(-1, 0);
+  } else if (this->buckets_right[index_right] == data) {
+    this->buckets_right[index_right] = EMPTY;
     this->number_of_elements--;
+  } else {
+    for (size_t i = 0; i < this->stash_size; i++) {
+      if (this->stash[i] == data) {
+        this->stash[i] = this->stash[--this->stash_size];
+        this->number_of_elements--;
+        break;
+      }
+    }
   }
 
-  this->rehash_threshold = 6 * log2(number_of_elements);
+  update_rehash_threshold();
 }
 
-void CuckooHashTable::rehash()
+template <typename Hash, typename Capacity, typename Insertion>
+void BasicCuckooHashTable<Hash, Capacity, Insertion>::rehash(int pending)
 {
-  this->is_rehashing = true;
-  bool success = false;
+  std::vector<int> elements(1, pending);
+  for (int data : this->buckets_left) {
+    if (data != EMPTY) elements.push_back(data);
+  }
+  for (int data : this->buckets_right) {
+    if (data != EMPTY) elements.push_back(data);
+  }
+  elements.insert(elements.end(), this->stash.begin(), this->stash.begin() + this->stash_size);
 
+  bool success = false;
   while (!success) {
-    std::vector<std::pair<int, size_t>> old_left = this->buckets_left;
-    std::vector<std::pair<int, size_t>> old_right = this->buckets_right;
-
     init(this->number_of_buckets);
+    this->number_of_rehashes++;
 
     success = true;
-
-    for (auto it : old_left) {
-      int data = it.first;
-      success &= insert_in(std::pair<int, size_t>(data, 0));
+    for (int data : elements) {
+      success = place(data);
       if (!success) break;
     }
+  }
+}
 
-    for (auto it : old_right) {
-      int data = it.first;
-      success &= insert_in(std::pair<int, size_t>(data, 0));
-      if (!success) break;
-    }
+template <typename Hash, typename Capacity, typename Insertion>
+typename BasicCuckooHashTable<Hash, Capacity, Insertion>::Stats BasicCuckooHashTable<Hash, Capacity, Insertion>::stats() const
+{
+  Stats result;
+  result.rehashes = this->number_of_rehashes;
+  result.stash_hits = this->stash_hits;
+  result.stash_size = this->stash_size;
+  return result;
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+size_t BasicCuckooHashTable<Hash, Capacity, Insertion>::size() const
+{
+  return this->number_of_elements;
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+size_t BasicCuckooHashTable<Hash, Capacity, Insertion>::slot_count() const
+{
+  return 2 * this->number_of_buckets + kStashSize;
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+bool BasicCuckooHashTable<Hash, Capacity, Insertion>::key_at(size_t slot, int& key) const
+{
+  if (slot < this->number_of_buckets) {
+    key = this->buckets_left[slot];
+  } else if (slot < 2 * this->number_of_buckets) {
+    key = this->buckets_right[slot - this->number_of_buckets];
+  } else {
+    slot -= 2 * this->number_of_buckets;
+    if (slot >= this->stash_size) return false;
+    key = this->stash[slot];
   }
+  return key != EMPTY;
+}
+
+template <typename Hash, typename Capacity, typename Insertion>
+size_t BasicCuckooHashTable<Hash, Capacity, Insertion>::migration_anchor() const
+{
+  return 0;
+}
 
+template <typename Hash, typename Capacity, typename Insertion>
+void BasicCuckooHashTable<Hash, Capacity, Insertion>::update_rehash_threshold()
+{
+  this->rehash_threshold = std::max<size_t>(5, 6 * log2(this->number_of_elements));
 }
 
-inline std::pair<size_t, size_t> CuckooHashTable::indices_for_data(int data) const
+template <typename Hash, typename Capacity, typename Insertion>
+inline std::pair<size_t, size_t> BasicCuckooHashTable<Hash, Capacity, Insertion>::indices_for_data(int data) const
 {
   size_t hash_value_left = this->hash_function_left(data);
-  size_t index_left = hash_value_left % this->number_of_buckets;
+  size_t index_left = this->capacity.index(hash_value_left);
 
   size_t hash_value_right = this->hash_function_right(data);
-  size_t index_right = hash_value_right % this->number_of_buckets;
+  size_t index_right = this->capacity.index(hash_value_right);
 
   return std::pair<size_t, size_t>(index_left, index_right);
 }
+
+#define INSTANTIATE(Hash, Capacity)                                              \
+  template class BasicCuckooHashTable<Hash, Capacity, RandomWalkInsertion>;     \
+  template class BasicCuckooHashTable<Hash, Capacity, BreadthFirstInsertion>;
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
@@ -2,9 +2,35 @@
 #define CuckooHashTable_Included
 
 #include <vector>
+#include <array>
 #include "Hashes.h"
+#include "Capacity.h"
+#include "Batch.h"
 
-class CuckooHashTable {
+/**
+ * The table is templated on the type of its hash function. With Hash =
+ * HashFunction it accepts any HashFamily; with one of the concrete hashers
+ * from Hashes.h (e.g. TabulationHash) it must be given the matching family,
+ * and the hash is inlined into every probe.
+ *
+ * The Capacity policy (see Capacity.h) decides how hashes are mapped onto
+ * buckets. The default, ModuloCapacity, keeps the requested bucket count;
+ * PowerOfTwoCapacity and FastRangeCapacity trade exactness or hash quality
+ * requirements for cheaper index arithmetic.
+ *
+ * The Insertion policy picks how a place is made for a new key when both of
+ * its buckets are taken, as described at insert() below.
+ */
+struct RandomWalkInsertion {
+  static const bool kBreadthFirst = false;
+};
+
+struct BreadthFirstInsertion {
+  static const bool kBreadthFirst = true;
+};
+
+template <typename Hash, typename Capacity = ModuloCapacity, typename Insertion = RandomWalkInsertion>
+class BasicCuckooHashTable {
  public:
   /**
    * Constructs a new cuckoo hash table with the specified number of buckets,
@@ -16,11 +42,11 @@ class CuckooHashTable {
    * buckets once the hash table has initially be created.
    *
    * You can choose a hash function out of the family of hash functions by
-   * declaring a variable of type HashFunction and assigning it the value
-   * family->get(). For example:
+   * declaring a variable of type Hash and assigning it the value
+   * sampleHash<Hash>(family). For example:
    *
-   *    HashFunction h;
-   *    h = family->get();
+   *    Hash h;
+   *    h = sampleHash<Hash>(family);
    *
    * Because cuckoo hashing may require a rehash if elements can't be placed
    * into the table, you will need to store the hash family for later use.
@@ -30,12 +56,12 @@ class CuckooHashTable {
    *
    * and assigning 'family' to it.
    */
-  CuckooHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+  BasicCuckooHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
   
   /**
    * Cleans up all memory allocated by this hash table.
    */
-  ~CuckooHashTable();
+  ~BasicCuckooHashTable();
   
   /**
    * Inserts the specified element into this hash table. If the element already
@@ -45,11 +71,23 @@ class CuckooHashTable {
    * displacements occur. To do so, keep track of the number of times that you
    * have displaced an element. If it ever exceeds 6 lg n, you should trigger
    * a rehash.
+   *
+   * With RandomWalkInsertion (the default) the new key is placed right away,
+   * evicting the occupant to its other bucket, and so on. With
+   * BreadthFirstInsertion the chains of evictions starting at both of the
+   * key's buckets are searched breadth-first, without moving anything, for
+   * an empty bucket at most 6 lg n moves away. Only that shortest path is
+   * then applied.
+   *
+   * Either way, an element that can't be placed goes into a small stash of
+   * kStashSize elements instead. The table is only rehashed once the stash
+   * is full, so a single unlucky insertion doesn't cost O(n).
    */
   void insert(int key);
   
   /**
    * Returns whether the specified key is contained in this hash tasble.
+   * The stash is only scanned if the key is in neither of its buckets.
    */
   bool contains(int key) const;
   
@@ -59,33 +97,125 @@ class CuckooHashTable {
    */
   void remove(int key);
 
+  /**
+   * Batched lookup: sets out[i] to contains(keys[i]) for every i < n, after
+   * prefetching both buckets of a whole batch of keys (see Batch.h).
+   */
+  void contains_many(const int* keys, size_t n, bool* out) const;
+
+  /**
+   * Inserts keys[0], ..., keys[n - 1], prefetching both of their buckets a
+   * batch at a time. Keys that have to evict others still do so one by one.
+   */
+  void insert_many(const int* keys, size_t n);
+
+  /**
+   * Counters for judging how well the stash works: how often the table was
+   * rehashed, how many contains queries were answered from the stash (the
+   * duplicate checks of insert don't count), and how full the stash is
+   * right now.
+   */
+  struct Stats {
+    size_t rehashes;
+    size_t stash_hits;
+    size_t stash_size;
+  };
+
+  Stats stats() const;
+
+  static const size_t kStashSize = 4;
+
+  /**
+   * Access for GrowableHashTable, which drains a full table into a larger
+   * one a few slots at a time. The slots are the left buckets, then the
+   * right buckets, then the stash; key_at() says whether a slot holds a key,
+   * and which. Removing a key never moves another one, except that the last
+   * stash entry fills the hole, so it only moves to a lower slot and
+   * migration can start from slot 0 going down.
+   */
+  size_t size() const;
+  size_t slot_count() const;
+  bool key_at(size_t slot, int& key) const;
+  size_t migration_anchor() const;
+
+  /* The load factor above which GrowableHashTable grows the table. Past
+   * one half, cuckoo hashing with two choices fails to place keys.
+   */
+  static constexpr double kMaxLoadFactor = 0.4;
+
   inline std::pair<size_t, size_t> indices_for_data(int data) const;  
 
 private:
-  void init(int number_of_buckets);
+  void init(size_t number_of_buckets);
+
+  /* contains, given both buckets of data. */
+  bool contains_at(int data, std::pair<size_t, size_t> indices) const;
+
+  /* The same test without counting a stash hit, for insert's duplicate check. */
+  bool stored_at(int data, std::pair<size_t, size_t> indices) const;
+  bool in_stash(int data) const;
+
+  /* Places data by a random walk of evictions. Returns false if that takes
+   * more than rehash_threshold displacements; 'data' then holds the element
+   * left over, and the table still holds all the others.
+   */
+  bool insert_in(int& data);
+
+  /* Places data along the shortest eviction path found by breadth-first
+   * search. Returns false, leaving the table untouched, if there is none.
+   */
+  bool insert_along_path(int data);
+
+  /* A bucket visited by the search, linked to the bucket whose occupant
+   * would be evicted into it. Kept as a member so searching doesn't allocate.
+   */
+  struct PathStep {
+    bool left;
+    size_t index;
+    size_t parent;
+    size_t depth;
+  };
+  static const size_t kNoParent = size_t(-1);
+  std::vector<PathStep> search;
+
+  /* Draws new hash functions and reinserts every element plus 'pending',
+   * until everything fits into the tables and the stash.
+   */
+  void rehash(int pending);
+
+  /* Places data in the tables or, failing that, in the stash. Returns false
+   * if the stash is full; 'data' then holds the element left over.
+   */
+  bool place(int& data);
+  void update_rehash_threshold();
 
   std::shared_ptr<HashFamily> hash_family;
-  HashFunction hash_function_left;
-  HashFunction hash_function_right;
-  std::vector<std::pair<int, size_t>> buckets_left;
-  std::vector<std::pair<int, size_t>> buckets_right;
+  Hash hash_function_left;
+  Hash hash_function_right;
+  std::vector<int> buckets_left;
+  std::vector<int> buckets_right;
   size_t number_of_buckets;
+  Capacity capacity;
+
+  std::array<int, kStashSize> stash;
+  size_t stash_size;
 
-  bool insert_in(std::pair<int, size_t> data);
-  bool is_rehashing;
   bool insert_in_left;
   size_t rehash_threshold;
   size_t number_of_elements;
-  void rehash();
-//  inline std::pair<size_t, size_t> indices_for_data(int data) const;
+  size_t number_of_rehashes;
+  mutable size_t stash_hits;
   
   /* Fun with C++: these next two lines disable implicitly-generated copy
    * functions that would otherwise cause weird errors if you tried to
    * implicitly copy an object of this type. You don't need to touch these
    * lines.
    */
-  CuckooHashTable(CuckooHashTable const &) = delete;
-  void operator=(CuckooHashTable const &) = delete;
+  BasicCuckooHashTable(BasicCuckooHashTable const &) = delete;
+  void operator=(BasicCuckooHashTable const &) = delete;
 };
 
+/* The type-erased table, usable with every hash family. */
+using CuckooHashTable = BasicCuckooHashTable<HashFunction>;
+
 #endif
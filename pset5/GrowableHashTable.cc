@@ -0,0 +1,89 @@
+#include "GrowableHashTable.h"
+#include "LinearProbingHashTable.h"
+#include "RobinHoodHashTable.h"
+#include "CuckooHashTable.h"
+
+template <typename HT>
+GrowableHashTable<HT>::GrowableHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
+{
+  this->family = family;
+  this->table.reset(new HT(numBuckets, family));
+  this->anchor = 0;
+  this->migrated = 0;
+  this->number_of_elements = 0;
+}
+
+template <typename HT>
+GrowableHashTable<HT>::~GrowableHashTable()
+{
+  // unique_ptrs clean up after themselves
+}
+
+template <typename HT>
+void GrowableHashTable<HT>::insert(int data)
+{
+  if (this->contains(data)) return;
+
+  if (this->table->size() + 1 > HT::kMaxLoadFactor * this->table->slot_count()) {
+    grow();
+  }
+  this->table->insert(data);
+  this->number_of_elements++;
+  if (this->draining) migrate();
+}
+
+template <typename HT>
+bool GrowableHashTable<HT>::contains(int data) const
+{
+  return this->table->contains(data) || (this->draining && this->draining->contains(data));
+}
+
+template <typename HT>
+void GrowableHashTable<HT>::remove(int data)
+{
+  if (!this->contains(data)) return;
+
+  this->table->remove(data);
+  if (this->draining) {
+    this->draining->remove(data);
+    migrate();
+  }
+  this->number_of_elements--;
+}
+
+template <typename HT>
+size_t GrowableHashTable<HT>::size() const
+{
+  return this->number_of_elements;
+}
+
+template <typename HT>
+void GrowableHashTable<HT>::grow()
+{
+  // kMigrationStep should make this a no-op, but never drain two tables at once
+  while (this->draining) migrate();
+
+  size_t numBuckets = 2 * this->table->slot_count();
+  this->draining = std::move(this->table);
+  this->table.reset(new HT(numBuckets, this->family));
+  this->anchor = this->draining->migration_anchor();
+  this->migrated = 0;
+}
+
+template <typename HT>
+void GrowableHashTable<HT>::migrate()
+{
+  size_t slots = this->draining->slot_count();
+  for (size_t step = 0; step < kMigrationStep && this->migrated < slots; step++) {
+    this->migrated++;
+    size_t slot = (this->anchor + slots - this->migrated) % slots;
+    int key;
+    if (this->draining->key_at(slot, key)) this->table->insert(key);
+  }
+  if (this->migrated == slots) this->draining.reset();
+}
+
+template class GrowableHashTable<LinearProbingHashTable>;
+template class GrowableHashTable<BasicLinearProbingHashTable<HashFunction, ModuloCapacity, BackwardShiftDeletion>>;
+template class GrowableHashTable<RobinHoodHashTable>;
+template class GrowableHashTable<CuckooHashTable>;
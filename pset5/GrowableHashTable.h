@@ -0,0 +1,93 @@
+#ifndef GrowableHashTable_Included
+#define GrowableHashTable_Included
+
+#include "Hashes.h"
+
+#include <memory>
+
+/**
+ * Wraps one of the fixed-size tables (LinearProbingHashTable,
+ * RobinHoodHashTable or CuckooHashTable) so that it grows as keys are added.
+ * The fixed-size tables themselves are left alone, so the load factors in
+ * our timing experiments stay exact.
+ *
+ * Once the table passes HT::kMaxLoadFactor, a table twice its size is
+ * allocated and all new keys go there. The old table is drained into the
+ * new one incrementally: every insert and remove moves the keys of the next
+ * kMigrationStep slots across. Until it is empty, lookups check both tables.
+ * No single operation has to pay for rehashing every key.
+ *
+ * kMigrationStep is large enough that the old table is always drained
+ * before the new table fills up in turn.
+ */
+template <typename HT>
+class GrowableHashTable {
+public:
+  /**
+   * Constructs a new table that starts out with the specified number of
+   * buckets, using hash functions drawn from the indicated family of hash
+   * functions.
+   */
+  GrowableHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+
+  /**
+   * Cleans up all memory allocated by this hash table.
+   */
+  ~GrowableHashTable();
+
+  /**
+   * Inserts the specified element into this hash table. If the element already
+   * exists, this operation is a no-op.
+   */
+  void insert(int key);
+
+  /**
+   * Returns whether the specified key is contained in this hash table.
+   */
+  bool contains(int key) const;
+
+  /**
+   * Removes the specified element from this hash table. If the element is not
+   * present in the hash table, this operation is a no-op.
+   */
+  void remove(int key);
+
+  /**
+   * Returns the number of keys in the table.
+   */
+  size_t size() const;
+
+  static const size_t kMigrationStep = 8;
+
+private:
+  /* Makes a table twice as large the one to insert into, and starts draining
+   * the current one into it.
+   */
+  void grow();
+
+  /* Moves the keys of the next kMigrationStep slots of the draining table
+   * across, and drops it once it has been scanned completely.
+   *
+   * Slots are scanned downwards from just below the draining table's
+   * migration_anchor(). Removals only ever move a key to a lower slot in
+   * that order, so a key can't slip past the scan.
+   */
+  void migrate();
+
+  std::shared_ptr<HashFamily> family;
+  std::unique_ptr<HT> table;    // receives all insertions
+  std::unique_ptr<HT> draining; // the previous table, or null
+  size_t anchor;
+  size_t migrated;              // slots of 'draining' scanned so far
+  size_t number_of_elements;
+
+  /* Fun with C++: these next two lines disable implicitly-generated copy
+   * functions that would otherwise cause weird errors if you tried to
+   * implicitly copy an object of this type. You don't need to touch these
+   * lines.
+   */
+  GrowableHashTable(GrowableHashTable const &) = delete;
+  void operator=(GrowableHashTable const &) = delete;
+};
+
+#endif
@@ -2,31 +2,42 @@
 #include <random>
 #include <array>
 
-static std::default_random_engine engine(137);
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_AVX2_GATHER 1
+#endif
 
-static const size_t kLargePrime = (1u << 31) - 1;
-
-static size_t randomFieldElem() {
+static size_t randomFieldElem(HashEngine& engine) {
   std::uniform_int_distribution<size_t> dist(0, kLargePrime - 1);
   return dist(engine);
 }
 
-static size_t random32Bits() {
+static size_t random32Bits(HashEngine& engine) {
   std::uniform_int_distribution<size_t> dist;
   return dist(engine);
 }
 
+static uint64_t random64Bits(HashEngine& engine) {
+  std::uniform_int_distribution<uint64_t> dist;
+  return dist(engine);
+}
+
+static uint64_t randomMersenneElem(HashEngine& engine) {
+  std::uniform_int_distribution<uint64_t> dist(0, kMersennePrime - 1);
+  return dist(engine);
+}
+
 
-std::shared_ptr<HashFamily> twoIndependentHashFamily() {
-  class TwoIndependentHashFamily: public HashFamily {
+std::shared_ptr<HashFamily> twoIndependentHashFamily(uint64_t seed) {
+  class TwoIndependentHashFamily: public TypedHashFamily<TwoIndependentHash> {
   public:
-    virtual HashFunction get() const {
-      size_t a = randomFieldElem();
-      size_t b = randomFieldElem();
-      
-      return [a, b] (int key) {
-        return (a * key + b) % kLargePrime;
-      };
+    using TypedHashFamily<TwoIndependentHash>::TypedHashFamily;
+
+    virtual TwoIndependentHash sample(HashEngine& engine) const {
+      TwoIndependentHash hash;
+      hash.a = randomFieldElem(engine);
+      hash.b = randomFieldElem(engine);
+      return hash;
     }
     
     virtual std::string name() const {
@@ -34,20 +45,20 @@ std::shared_ptr<HashFamily> twoIndependentHashFamily() {
     }
   };
   
-  return std::make_shared<TwoIndependentHashFamily>();
+  return std::make_shared<TwoIndependentHashFamily>(seed);
 }
 
-std::shared_ptr<HashFamily> threeIndependentHashFamily() {
-  class ThreeIndependentHashFamily: public HashFamily {
+std::shared_ptr<HashFamily> threeIndependentHashFamily(uint64_t seed) {
+  class ThreeIndependentHashFamily: public TypedHashFamily<ThreeIndependentHash> {
   public:
-    virtual HashFunction get() const {
-      size_t a = randomFieldElem();
-      size_t b = randomFieldElem();
-      size_t c = randomFieldElem();
-      
-      return [a, b, c] (int key) {
-        return (a * key * key + b * key + c) % kLargePrime;
-      };
+    using TypedHashFamily<ThreeIndependentHash>::TypedHashFamily;
+
+    virtual ThreeIndependentHash sample(HashEngine& engine) const {
+      ThreeIndependentHash hash;
+      hash.a = randomFieldElem(engine);
+      hash.b = randomFieldElem(engine);
+      hash.c = randomFieldElem(engine);
+      return hash;
     }
     
     virtual std::string name() const {
@@ -55,23 +66,22 @@ std::shared_ptr<HashFamily> threeIndependentHashFamily() {
     }
   };
   
-  return std::make_shared<ThreeIndependentHashFamily>();
+  return std::make_shared<ThreeIndependentHashFamily>(seed);
 }
 
-std::shared_ptr<HashFamily> fiveIndependentHashFamily() {
-  class FiveIndependentHashFamily: public HashFamily {
+std::shared_ptr<HashFamily> fiveIndependentHashFamily(uint64_t seed) {
+  class FiveIndependentHashFamily: public TypedHashFamily<FiveIndependentHash> {
   public:
-    virtual HashFunction get() const {
-      size_t a = randomFieldElem();
-      size_t b = randomFieldElem();
-      size_t c = randomFieldElem();
-      size_t d = randomFieldElem();
-      size_t e = randomFieldElem();
-      
-      return [a, b, c, d, e] (int key) {
-        return (a * key * key * key * key + b * key * key * key + 
-                c * key * key + d * key + e) % kLargePrime;
-      };
+    using TypedHashFamily<FiveIndependentHash>::TypedHashFamily;
+
+    virtual FiveIndependentHash sample(HashEngine& engine) const {
+      FiveIndependentHash hash;
+      hash.a = randomFieldElem(engine);
+      hash.b = randomFieldElem(engine);
+      hash.c = randomFieldElem(engine);
+      hash.d = randomFieldElem(engine);
+      hash.e = randomFieldElem(engine);
+      return hash;
     }
     
     virtual std::string name() const {
@@ -79,27 +89,72 @@ std::shared_ptr<HashFamily> fiveIndependentHashFamily() {
     }
   };
   
-  return std::make_shared<FiveIndependentHashFamily>();
+  return std::make_shared<FiveIndependentHashFamily>(seed);
+}
+
+std::shared_ptr<HashFamily> multiplyShiftHashFamily(uint64_t seed) {
+  class MultiplyShiftHashFamily: public TypedHashFamily<MultiplyShiftHash> {
+  public:
+    using TypedHashFamily<MultiplyShiftHash>::TypedHashFamily;
+
+    virtual MultiplyShiftHash sample(HashEngine& engine) const {
+      MultiplyShiftHash hash;
+      hash.a = random64Bits(engine);
+      hash.b = random64Bits(engine);
+      return hash;
+    }
+
+    virtual std::string name() const {
+      return "2-Independent Multiply-Shift Hash";
+    }
+  };
+
+  return std::make_shared<MultiplyShiftHashFamily>(seed);
+}
+
+template <size_t K>
+static std::shared_ptr<HashFamily> mersennePolynomialHashFamily(uint64_t seed) {
+  class MersennePolynomialHashFamily: public TypedHashFamily<MersennePolynomialHash<K>> {
+  public:
+    using TypedHashFamily<MersennePolynomialHash<K>>::TypedHashFamily;
+
+    virtual MersennePolynomialHash<K> sample(HashEngine& engine) const {
+      MersennePolynomialHash<K> hash;
+      for (auto& coefficient : hash.coefficients) {
+        coefficient = randomMersenneElem(engine);
+      }
+      return hash;
+    }
+
+    virtual std::string name() const {
+      return std::to_string(K) + "-Independent Mersenne Polynomial Hash";
+    }
+  };
+
+  return std::make_shared<MersennePolynomialHashFamily>(seed);
+}
+
+std::shared_ptr<HashFamily> mersenneThreeIndependentHashFamily(uint64_t seed) {
+  return mersennePolynomialHashFamily<3>(seed);
+}
+
+std::shared_ptr<HashFamily> mersenneFiveIndependentHashFamily(uint64_t seed) {
+  return mersennePolynomialHashFamily<5>(seed);
 }
 
-std::shared_ptr<HashFamily> tabulationHashFamily() {
-  class TabulationHashFamily: public HashFamily {
+std::shared_ptr<HashFamily> tabulationHashFamily(uint64_t seed) {
+  class TabulationHashFamily: public TypedHashFamily<TabulationHash> {
   public:
-    virtual HashFunction get() const {
-      std::array<std::array<size_t, 256>, 4> table;
+    using TypedHashFamily<TabulationHash>::TypedHashFamily;
+
+    virtual TabulationHash sample(HashEngine& engine) const {
+      TabulationHash hash;
       for (size_t i = 0; i < 4; i++) {
         for (size_t byte = 0; byte < 256; byte++) {
-          table[i][byte] = random32Bits();
+          hash.table[i][byte] = random32Bits(engine);
         }
       }
-      
-      return [table] (int key) {
-        size_t result = 0;
-        for (size_t i = 0; i < 4; i++) {
-          result ^= table[i][(key & (0xFF << (i * 8))) >> (i * 8)];
-        }
-        return result % kLargePrime;
-      };
+      return hash;
     }
     
     virtual std::string name() const {
@@ -107,16 +162,37 @@ std::shared_ptr<HashFamily> tabulationHashFamily() {
     }
   };
   
-  return std::make_shared<TabulationHashFamily>();
+  return std::make_shared<TabulationHashFamily>(seed);
+}
+
+std::shared_ptr<HashFamily> compactTabulationHashFamily(uint64_t seed) {
+  class CompactTabulationHashFamily: public TypedHashFamily<CompactTabulationHash> {
+  public:
+    using TypedHashFamily<CompactTabulationHash>::TypedHashFamily;
+
+    virtual CompactTabulationHash sample(HashEngine& engine) const {
+      CompactTabulationHash hash;
+      for (size_t i = 0; i < 4; i++) {
+        for (size_t byte = 0; byte < 256; byte++) {
+          hash.table[i][byte] = uint32_t(random32Bits(engine));
+        }
+      }
+      return hash;
+    }
+
+    virtual std::string name() const {
+      return "3-Independent Tabulation Hash (32-bit)";
+    }
+  };
+
+  return std::make_shared<CompactTabulationHashFamily>(seed);
 }
 
 std::shared_ptr<HashFamily> identityHash() {
-  class IdentityHashFamily: public HashFamily {
+  class IdentityHashFamily: public TypedHashFamily<IdentityHash> {
   public:
-    virtual HashFunction get() const {
-      return [] (int key) {
-        return key;
-      };
+    virtual IdentityHash sample(HashEngine&) const {
+      return IdentityHash();
     }
     
     virtual std::string name() const {
@@ -128,18 +204,10 @@ std::shared_ptr<HashFamily> identityHash() {
 }
 
 std::shared_ptr<HashFamily> jenkinsHash() {
-  class JenkinsHashFamily: public HashFamily {
+  class JenkinsHashFamily: public TypedHashFamily<JenkinsHash> {
   public:
-    virtual HashFunction get() const {
-      return [] (int a) {
-        a = (a + 0x7ed55d16) + (a << 12);
-        a = (a ^ 0xc761c23c) ^ (a >> 19);
-        a = (a + 0x165667b1) + (a << 5);
-        a = (a + 0xd3a2646c) ^ (a << 9);
-        a = (a + 0xfd7046c5) + (a << 3);
-        a = (a ^ 0xb55a4f09) ^ (a >> 16);
-        return a;
-      };
+    virtual JenkinsHash sample(HashEngine&) const {
+      return JenkinsHash();
     }
     
     virtual std::string name() const {
@@ -149,3 +217,158 @@ std::shared_ptr<HashFamily> jenkinsHash() {
   
   return std::make_shared<JenkinsHashFamily>();
 }
+
+std::shared_ptr<BasicHashFamily<uint64_t>> tabulationHash64Family(uint64_t seed) {
+  class TabulationHash64Family: public TypedHashFamily<TabulationHash64, uint64_t> {
+  public:
+    using TypedHashFamily<TabulationHash64, uint64_t>::TypedHashFamily;
+
+    virtual TabulationHash64 sample(HashEngine& engine) const {
+      TabulationHash64 hash;
+      for (auto& table : hash.table) {
+        for (auto& entry : table) entry = random64Bits(engine);
+      }
+      return hash;
+    }
+
+    virtual std::string name() const {
+      return "Tabulation Hash (64-bit keys)";
+    }
+  };
+
+  return std::make_shared<TabulationHash64Family>(seed);
+}
+
+std::shared_ptr<BasicHashFamily<uint64_t>> wyHash64Family(uint64_t seed) {
+  class WyHash64Family: public TypedHashFamily<WyHash64, uint64_t> {
+  public:
+    using TypedHashFamily<WyHash64, uint64_t>::TypedHashFamily;
+
+    virtual WyHash64 sample(HashEngine& engine) const {
+      WyHash64 hash;
+      for (auto& secret : hash.secret) secret = random64Bits(engine) | 1;
+      return hash;
+    }
+
+    virtual std::string name() const {
+      return "wyhash-style Mixer (64-bit keys)";
+    }
+  };
+
+  return std::make_shared<WyHash64Family>(seed);
+}
+
+std::shared_ptr<BasicHashFamily<std::string>> byteTabulationHashFamily(uint64_t seed) {
+  class ByteTabulationHashFamily: public TypedHashFamily<ByteTabulationHash, std::string> {
+  public:
+    using TypedHashFamily<ByteTabulationHash, std::string>::TypedHashFamily;
+
+    virtual ByteTabulationHash sample(HashEngine& engine) const {
+      ByteTabulationHash hash;
+      for (auto& table : hash.table) {
+        for (auto& entry : table) entry = random64Bits(engine);
+      }
+      return hash;
+    }
+
+    virtual std::string name() const {
+      return "Byte Tabulation Hash (strings)";
+    }
+  };
+
+  return std::make_shared<ByteTabulationHashFamily>(seed);
+}
+
+std::shared_ptr<BasicHashFamily<std::string>> wyStringHashFamily(uint64_t seed) {
+  class WyStringHashFamily: public TypedHashFamily<WyStringHash, std::string> {
+  public:
+    using TypedHashFamily<WyStringHash, std::string>::TypedHashFamily;
+
+    virtual WyStringHash sample(HashEngine& engine) const {
+      WyStringHash hash;
+      for (auto& secret : hash.secret) secret = random64Bits(engine) | 1;
+      return hash;
+    }
+
+    virtual std::string name() const {
+      return "wyhash-style Mixer (strings)";
+    }
+  };
+
+  return std::make_shared<WyStringHashFamily>(seed);
+}
+
+/* Batched tabulation hashing. The four tables of a tabulation hash are laid
+ * out back to back, so byte i of a key indexes entry 256 * i + byte from the
+ * start of the first one; each AVX2 gather fetches that entry for a whole
+ * vector of keys. Whatever doesn't fill a vector is hashed one at a time.
+ */
+#ifdef HAVE_AVX2_GATHER
+
+static bool cpuHasAVX2() {
+  static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+  return hasAVX2;
+}
+
+/* Byte i of each key, offset to the start of table i. */
+__attribute__((target("avx2")))
+static inline __m256i tableIndices(__m256i keys, int i) {
+  __m256i bytes = _mm256_and_si256(_mm256_srli_epi32(keys, 8 * i), _mm256_set1_epi32(0xFF));
+  return _mm256_add_epi32(bytes, _mm256_set1_epi32(256 * i));
+}
+
+__attribute__((target("avx2")))
+static size_t hashManyAVX2(const TabulationHash& hash, const int* keys, size_t n, size_t* out) {
+  const long long* entries = reinterpret_cast<const long long*>(hash.table[0].data());
+  size_t done = 0;
+  for (; done + 8 <= n; done += 8) {
+    __m256i vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + done));
+    __m256i low = _mm256_setzero_si256();
+    __m256i high = _mm256_setzero_si256();
+    for (int i = 0; i < 4; i++) {
+      __m256i indices = tableIndices(vector, i);
+      low  = _mm256_xor_si256(low,  _mm256_i32gather_epi64(entries, _mm256_castsi256_si128(indices), 8));
+      high = _mm256_xor_si256(high, _mm256_i32gather_epi64(entries, _mm256_extracti128_si256(indices, 1), 8));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done), low);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done + 4), high);
+  }
+  return done;
+}
+
+__attribute__((target("avx2")))
+static size_t hashManyAVX2(const CompactTabulationHash& hash, const int* keys, size_t n, size_t* out) {
+  const int* entries = reinterpret_cast<const int*>(hash.table[0].data());
+  size_t done = 0;
+  for (; done + 8 <= n; done += 8) {
+    __m256i vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + done));
+    __m256i result = _mm256_setzero_si256();
+    for (int i = 0; i < 4; i++) {
+      result = _mm256_xor_si256(result, _mm256_i32gather_epi32(entries, tableIndices(vector, i), 4));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done), _mm256_cvtepu32_epi64(_mm256_castsi256_si128(result)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + done + 4), _mm256_cvtepu32_epi64(_mm256_extracti128_si256(result, 1)));
+  }
+  return done;
+}
+
+#endif
+
+template <typename Hash>
+static void hashManyTabulation(const Hash& hash, const int* keys, size_t n, size_t* out) {
+  size_t done = 0;
+#ifdef HAVE_AVX2_GATHER
+  if (cpuHasAVX2()) done = hashManyAVX2(hash, keys, n, out);
+#endif
+  for (; done < n; done++) {
+    out[done] = hash(keys[done]);
+  }
+}
+
+void hashMany(const TabulationHash& hash, const int* keys, size_t n, size_t* out) {
+  hashManyTabulation(hash, keys, n, out);
+}
+
+void hashMany(const CompactTabulationHash& hash, const int* keys, size_t n, size_t* out) {
+  hashManyTabulation(hash, keys, n, out);
+}
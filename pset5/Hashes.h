@@ -4,31 +4,81 @@
 #include <string>
 #include <functional>
 #include <memory>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
 
 /* Alias: HashFunction
  * ----------------------------------------------------------------------------
  * A type representing an object that can be called as a hash function. This
  * uses the C++ std::function type, which is essentially a smarter version of
  * a function pointer.
+ *
+ * Every hash table can be instantiated with HashFunction as its hasher, in
+ * which case it accepts any HashFamily. That flexibility costs an indirect
+ * call per hash evaluation; the concrete hashers below avoid it.
  */
 using HashFunction = std::function<size_t(int)>;
 
-/* Interface: HashFamily
+/* Struct: HashFunctionFor<Key>, Alias: BasicHashFunction<Key>
  * ----------------------------------------------------------------------------
- * An interface representing a family of hash functions. To sample from the
- * family uniformly at random, invoke the 'get' function, which will return a
- * random hash function from the family.
+ * HashFunctionFor<Key>::type is the type-erased hash function for keys of
+ * type Key, and BasicHashFunction<Key> is shorthand for it. For int keys this
+ * is HashFunction; other keys are passed by reference, since they may be long
+ * strings.
+ */
+template <typename Key>
+struct HashFunctionFor {
+  typedef std::function<size_t(const Key&)> type;
+};
+
+template <>
+struct HashFunctionFor<int> {
+  typedef HashFunction type;
+};
+
+template <typename Key>
+using BasicHashFunction = typename HashFunctionFor<Key>::type;
+
+/* Alias: HashEngine
+ * ----------------------------------------------------------------------------
+ * The random number generator hash functions are drawn with. Unlike
+ * std::default_random_engine, std::mt19937_64 is the same generator in every
+ * standard library, so a seed picks the same hash functions everywhere.
+ */
+using HashEngine = std::mt19937_64;
+
+/* The seed of every family not given one of its own. */
+static const uint64_t kDefaultHashSeed = 137;
+
+/* Interface: BasicHashFamily<Key>, HashFamily
+ * ----------------------------------------------------------------------------
+ * An interface representing a family of hash functions for keys of type Key;
+ * HashFamily is the family for int keys that all of the tables use by
+ * default. To sample from the family uniformly at random, invoke the 'get'
+ * function, which will return a random hash function from the family.
  *
  * It is possible that the HashFactory wraps a family containing a single hash
  * function. You can assume that, for hash tables that require a family of
  * multiple hash functions, the hash factory will actually represent such a
  * family. For the other hash tables, it is entirely possible that there is
  * just a single hash function that will alwayas be returned.
+ *
+ * Every family owns a generator, seeded when the family is made, and get()
+ * draws from it. Families made with the same seed hand out the same hash
+ * functions in the same order, independently of any other family.
  */
-class HashFamily {
+template <typename Key>
+class BasicHashFamily {
 public:
+  explicit BasicHashFamily(uint64_t seed = kDefaultHashSeed) : engine(seed) {}
+
   /* C++ism: Interface classes need virtual destructors. */
-  virtual ~HashFamily() = default;
+  virtual ~BasicHashFamily() = default;
   
   /**
    * Function: get()
@@ -38,8 +88,25 @@ public:
    *
    *    HashFunction h = hashFamily->get();
    *    size_t bucket = h(key) % numBuckets;
+   *
+   * The function is drawn from the family's own generator. It is safe to
+   * call get() from several threads at once, but then the order of the calls
+   * decides which thread gets which function.
    */
-  virtual HashFunction get() const = 0;
+  BasicHashFunction<Key> get() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return get(this->engine);
+  }
+
+  /**
+   * Function: get(engine)
+   * --------------------------------------------------------------------------
+   * Returns a hash function drawn with the given generator instead, leaving
+   * the family's own untouched. The result depends on engine alone, so a
+   * caller that seeds its own generator can replay its choices exactly, on
+   * any thread, whatever else is sampled from the family.
+   */
+  virtual BasicHashFunction<Key> get(HashEngine& engine) const = 0;
   
   /**
    * Function: name()
@@ -48,8 +115,417 @@ public:
    * logging purposes.
    */
   virtual std::string name() const = 0; // Purely for testing purposes 
+
+protected:
+  mutable HashEngine engine;
+  mutable std::mutex mutex; // guards engine
+};
+
+using HashFamily = BasicHashFamily<int>;
+
+/* Class: TypedHashFamily<Hash, Key>
+ * ----------------------------------------------------------------------------
+ * A BasicHashFamily<Key> whose members all share the concrete functor type
+ * Hash. In addition to the type-erased 'get', such a family can hand out the
+ * functor itself via 'sample', which lets hash tables templated on Hash
+ * inline the hash evaluation into their probe loops.
+ */
+template <typename Hash, typename Key = int>
+class TypedHashFamily: public BasicHashFamily<Key> {
+public:
+  using BasicHashFamily<Key>::BasicHashFamily;
+
+  /**
+   * Function: sample(), sample(engine)
+   * --------------------------------------------------------------------------
+   * Returns a uniformly-random hash function from the family, as a concrete
+   * functor rather than a HashFunction. Like get(), it draws from the
+   * family's generator or from the one given.
+   */
+  Hash sample() const {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return sample(this->engine);
+  }
+
+  virtual Hash sample(HashEngine& engine) const = 0;
+
+  using BasicHashFamily<Key>::get;
+
+  virtual BasicHashFunction<Key> get(HashEngine& engine) const {
+    return sample(engine);
+  }
+};
+
+/* The prime modulus used by the polynomial hash families. */
+static const size_t kLargePrime = (1u << 31) - 1;
+
+/**
+ * Concrete hash functors, one per family below. Each can be sampled from its
+ * family through TypedHashFamily<Hash>::sample().
+ */
+struct TwoIndependentHash {
+  size_t a, b;
+
+  size_t operator()(int key) const {
+    return (a * key + b) % kLargePrime;
+  }
+};
+
+struct ThreeIndependentHash {
+  size_t a, b, c;
+
+  size_t operator()(int key) const {
+    return (a * key * key + b * key + c) % kLargePrime;
+  }
+};
+
+struct FiveIndependentHash {
+  size_t a, b, c, d, e;
+
+  size_t operator()(int key) const {
+    return (a * key * key * key * key + b * key * key * key +
+            c * key * key + d * key + e) % kLargePrime;
+  }
+};
+
+/* Dietzfelbinger's multiply-add-shift scheme: with a and b uniformly random
+ * 64-bit values, the upper 32 bits of a * key + b are 2-independent over
+ * 32-bit keys. Overflow is part of the scheme, so it takes a multiplication
+ * and no division at all.
+ */
+struct MultiplyShiftHash {
+  uint64_t a, b;
+
+  size_t operator()(int key) const {
+    return (a * uint64_t(uint32_t(key)) + b) >> 32;
+  }
+};
+
+/* The Mersenne prime 2^61 - 1. Reducing modulo it takes a shift, a mask and
+ * an addition instead of a division.
+ */
+static const uint64_t kMersennePrime = (uint64_t(1) << 61) - 1;
+
+/* Maps x < 2^122 to a value below 2^62 that is congruent to it modulo
+ * kMersennePrime, using 2^61 = 1.
+ */
+inline uint64_t foldMersenne(unsigned __int128 x) {
+  return uint64_t(x & kMersennePrime) + uint64_t(x >> 61);
+}
+
+/* Reduces x < 2^122 modulo kMersennePrime. */
+inline uint64_t reduceMersenne(unsigned __int128 x) {
+  uint64_t folded = foldMersenne(x);
+  folded = (folded & kMersennePrime) + (folded >> 61);
+  return folded >= kMersennePrime ? folded - kMersennePrime : folded;
+}
+
+/* A random polynomial of degree K - 1 over the integers modulo 2^61 - 1,
+ * which is K-independent. It is evaluated by Horner's rule with 128-bit
+ * products. The intermediate results are only folded below 2^62, which is
+ * small enough for the next product; the last one is reduced fully.
+ */
+template <size_t K>
+struct MersennePolynomialHash {
+  std::array<uint64_t, K> coefficients; // highest degree first, each < 2^61 - 1
+
+  size_t operator()(int key) const {
+    uint64_t x = uint32_t(key);
+    uint64_t result = coefficients[0];
+    for (size_t i = 1; i < K; i++) {
+      result = foldMersenne((unsigned __int128) result * x + coefficients[i]);
+    }
+    return reduceMersenne(result);
+  }
+};
+
+using MersenneThreeIndependentHash = MersennePolynomialHash<3>;
+using MersenneFiveIndependentHash = MersennePolynomialHash<5>;
+
+/* The table entries are uniformly random, so the XOR of four of them already
+ * is a uniformly random 64-bit value; tabulation hashing needs no final
+ * reduction modulo a prime.
+ */
+struct TabulationHash {
+  std::array<std::array<size_t, 256>, 4> table;
+
+  size_t operator()(int key) const {
+    uint32_t bits = uint32_t(key);
+    return table[0][bits & 0xFF] ^ table[1][(bits >> 8) & 0xFF] ^
+           table[2][(bits >> 16) & 0xFF] ^ table[3][bits >> 24];
+  }
+};
+
+/* Tabulation hashing with 32-bit table entries: 4 KiB of tables instead of
+ * 8 KiB, so they stay in L1 next to the buckets being probed, at the price of
+ * hash values of only 32 bits.
+ */
+struct CompactTabulationHash {
+  std::array<std::array<uint32_t, 256>, 4> table;
+
+  size_t operator()(int key) const {
+    uint32_t bits = uint32_t(key);
+    return table[0][bits & 0xFF] ^ table[1][(bits >> 8) & 0xFF] ^
+           table[2][(bits >> 16) & 0xFF] ^ table[3][bits >> 24];
+  }
+};
+
+struct IdentityHash {
+  size_t operator()(int key) const {
+    return key;
+  }
+};
+
+struct JenkinsHash {
+  size_t operator()(int a) const {
+    a = (a + 0x7ed55d16) + (a << 12);
+    a = (a ^ 0xc761c23c) ^ (a >> 19);
+    a = (a + 0x165667b1) + (a << 5);
+    a = (a + 0xd3a2646c) ^ (a << 9);
+    a = (a + 0xfd7046c5) + (a << 3);
+    a = (a ^ 0xb55a4f09) ^ (a >> 16);
+    return a;
+  }
 };
 
+/**
+ * Hashers for keys other than int, for tables instantiated with a different
+ * key type (see Keys.h). Each has a family below of the matching key type.
+ */
+
+/* wyhash's mixing step: the full 128-bit product of a and b, folded to 64
+ * bits. Every input bit reaches the middle of the product.
+ */
+inline uint64_t wyMix(uint64_t a, uint64_t b) {
+  unsigned __int128 product = (unsigned __int128) a * b;
+  return uint64_t(product) ^ uint64_t(product >> 64);
+}
+
+/* Reads eight bytes of a string as an integer, whatever their alignment. */
+inline uint64_t readWord(const char* bytes) {
+  uint64_t word;
+  std::memcpy(&word, bytes, sizeof(word));
+  return word;
+}
+
+/* Simple tabulation hashing over the eight bytes of a 64-bit key. */
+struct TabulationHash64 {
+  std::array<std::array<size_t, 256>, 8> table;
+
+  size_t operator()(uint64_t key) const {
+    size_t result = 0;
+    for (size_t i = 0; i < 8; i++) {
+      result ^= table[i][(key >> (i * 8)) & 0xFF];
+    }
+    return result;
+  }
+};
+
+/* A wyhash-style mixer for 64-bit keys, with random secrets. */
+struct WyHash64 {
+  std::array<uint64_t, 3> secret;
+
+  size_t operator()(uint64_t key) const {
+    return wyMix(wyMix(key ^ secret[0], secret[1]), secret[2]);
+  }
+};
+
+/* Tabulation hashing over the bytes of a string. Byte i is looked up in
+ * table i mod 8, and the entry is rotated by i / 8 bits, so that equal bytes
+ * at different positions don't cancel. For strings of up to eight bytes this
+ * is simple tabulation; longer strings reuse the tables, which keeps the hash
+ * fast but weakens its guarantees.
+ */
+struct ByteTabulationHash {
+  std::array<std::array<size_t, 256>, 8> table;
+
+  size_t operator()(const std::string& key) const {
+    size_t result = 0;
+    for (size_t i = 0; i < key.size(); i++) {
+      size_t entry = table[i % 8][uint8_t(key[i])];
+      unsigned rotation = (i / 8) % 64;
+      result ^= rotation ? entry << rotation | entry >> (64 - rotation) : entry;
+    }
+    return result;
+  }
+};
+
+/* A wyhash-style mixer for strings: the string is consumed sixteen bytes at
+ * a time, each block mixed into the running state with one 128-bit
+ * multiplication, and the length is mixed in at the end.
+ */
+struct WyStringHash {
+  std::array<uint64_t, 3> secret;
+
+  size_t operator()(const std::string& key) const {
+    const char* bytes = key.data();
+    size_t remaining = key.size();
+    uint64_t state = secret[0];
+    for (; remaining > 16; bytes += 16, remaining -= 16) {
+      state = wyMix(readWord(bytes) ^ secret[1], readWord(bytes + 8) ^ state);
+    }
+    uint64_t tail[2] = {0, 0};
+    std::memcpy(tail, bytes, remaining);
+    state = wyMix(tail[0] ^ secret[1], tail[1] ^ state);
+    return wyMix(state ^ secret[2], key.size() ^ secret[1]);
+  }
+};
+
+/**
+ * Function: sampleHash<Hash>(family), sampleHash<Hash>(family, engine)
+ * ----------------------------------------------------------------------------
+ * Samples a hash function of type Hash from the given family of hash
+ * functions for keys of type Key, with the family's generator or the one
+ * given. For Hash = BasicHashFunction<Key> this works with any such family;
+ * otherwise the family must be a TypedHashFamily<Hash, Key>, and
+ * std::invalid_argument is thrown if it is not.
+ */
+template <typename Hash, typename Key>
+const TypedHashFamily<Hash, Key>& typedFamily(const std::shared_ptr<BasicHashFamily<Key>>& family) {
+  auto typed = dynamic_cast<const TypedHashFamily<Hash, Key>*>(family.get());
+  if (!typed) {
+    throw std::invalid_argument("Hash family " + family->name() +
+                                " does not produce the requested hash type.");
+  }
+  return *typed;
+}
+
+template <typename Hash, typename Key>
+Hash sampleHash(const std::shared_ptr<BasicHashFamily<Key>>& family, std::false_type) {
+  return typedFamily<Hash>(family).sample();
+}
+
+template <typename Hash, typename Key>
+Hash sampleHash(const std::shared_ptr<BasicHashFamily<Key>>& family, std::true_type) {
+  return family->get();
+}
+
+template <typename Hash, typename Key>
+Hash sampleHash(const std::shared_ptr<BasicHashFamily<Key>>& family) {
+  return sampleHash<Hash>(family, std::is_same<Hash, BasicHashFunction<Key>>());
+}
+
+template <typename Hash, typename Key>
+Hash sampleHash(const std::shared_ptr<BasicHashFamily<Key>>& family, HashEngine& engine, std::false_type) {
+  return typedFamily<Hash>(family).sample(engine);
+}
+
+template <typename Hash, typename Key>
+Hash sampleHash(const std::shared_ptr<BasicHashFamily<Key>>& family, HashEngine& engine, std::true_type) {
+  return family->get(engine);
+}
+
+template <typename Hash, typename Key>
+Hash sampleHash(const std::shared_ptr<BasicHashFamily<Key>>& family, HashEngine& engine) {
+  return sampleHash<Hash>(family, engine, std::is_same<Hash, BasicHashFunction<Key>>());
+}
+
+/**
+ * Trait: HashSerialization<Hash>
+ * ----------------------------------------------------------------------------
+ * The concrete hashers are plain structs of their seeds, coefficients or
+ * tables, so saving one means saving its bytes. kSerializable says whether
+ * Hash is such a hasher; the type-erased HashFunction is not. readHash turns
+ * saved bytes back into a hasher, and throws std::logic_error for a hasher
+ * that can't be serialized.
+ */
+template <typename Hash>
+struct HashSerialization {
+  static const bool kSerializable = false;
+};
+
+#define SERIALIZABLE_HASH(Hash)                                              \
+  template <>                                                                \
+  struct HashSerialization<Hash> {                                           \
+    static_assert(std::is_trivially_copyable<Hash>::value, #Hash " must be a plain struct"); \
+    static const bool kSerializable = true;                                  \
+  };
+
+SERIALIZABLE_HASH(TwoIndependentHash)
+SERIALIZABLE_HASH(ThreeIndependentHash)
+SERIALIZABLE_HASH(FiveIndependentHash)
+SERIALIZABLE_HASH(MultiplyShiftHash)
+SERIALIZABLE_HASH(MersenneThreeIndependentHash)
+SERIALIZABLE_HASH(MersenneFiveIndependentHash)
+SERIALIZABLE_HASH(TabulationHash)
+SERIALIZABLE_HASH(CompactTabulationHash)
+SERIALIZABLE_HASH(IdentityHash)
+SERIALIZABLE_HASH(JenkinsHash)
+SERIALIZABLE_HASH(TabulationHash64)
+SERIALIZABLE_HASH(WyHash64)
+SERIALIZABLE_HASH(ByteTabulationHash)
+SERIALIZABLE_HASH(WyStringHash)
+
+template <typename Hash>
+Hash readHash(const void* bytes, std::true_type) {
+  Hash hash;
+  std::memcpy(&hash, bytes, sizeof(hash));
+  return hash;
+}
+
+template <typename Hash>
+Hash readHash(const void*, std::false_type) {
+  throw std::logic_error("This hash function can't be serialized.");
+}
+
+template <typename Hash>
+Hash readHash(const void* bytes) {
+  return readHash<Hash>(bytes, std::integral_constant<bool, HashSerialization<Hash>::kSerializable>());
+}
+
+/**
+ * Function: hashMany(hash, keys, n, out)
+ * ----------------------------------------------------------------------------
+ * Stores hash(keys[i]) in out[i] for each of the n keys. The batched table
+ * operations hash their keys through this. For most hashers it is just a
+ * loop; the tabulation hashers have overloads that, on CPUs with AVX2, look
+ * up the table entries for eight keys at once with gather instructions.
+ */
+template <typename Hash, typename Key>
+void hashMany(const Hash& hash, const Key* keys, size_t n, size_t* out) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = hash(keys[i]);
+  }
+}
+
+void hashMany(const TabulationHash& hash, const int* keys, size_t n, size_t* out);
+void hashMany(const CompactTabulationHash& hash, const int* keys, size_t n, size_t* out);
+
+/**
+ * Macro: FOR_EACH_HASH(X)
+ * ----------------------------------------------------------------------------
+ * Expands X(Hash) once for every hasher type the tables support, including
+ * the type-erased HashFunction. The table implementations use this to
+ * explicitly instantiate their templates in their .cc files.
+ */
+#define FOR_EACH_HASH(X)    \
+  X(HashFunction)           \
+  X(TwoIndependentHash)     \
+  X(ThreeIndependentHash)   \
+  X(FiveIndependentHash)    \
+  X(MultiplyShiftHash)      \
+  X(MersenneThreeIndependentHash) \
+  X(MersenneFiveIndependentHash)  \
+  X(TabulationHash)         \
+  X(CompactTabulationHash)  \
+  X(IdentityHash)           \
+  X(JenkinsHash)
+
+/**
+ * Macros: FOR_EACH_UINT64_HASH(X), FOR_EACH_STRING_HASH(X)
+ * ----------------------------------------------------------------------------
+ * The same for tables with 64-bit and with string keys.
+ */
+#define FOR_EACH_UINT64_HASH(X)         \
+  X(BasicHashFunction<uint64_t>)        \
+  X(TabulationHash64)                   \
+  X(WyHash64)
+
+#define FOR_EACH_STRING_HASH(X)         \
+  X(BasicHashFunction<std::string>)     \
+  X(ByteTabulationHash)                 \
+  X(WyStringHash)
+
 /**
  * These functions return pointers to specific families of hash functions.
  *
@@ -59,22 +535,59 @@ public:
  *      A family of 3-independent hash functions using random polynomials.
  *   fiveIndependentHashFamily:
  *      A family of 5-independent hash functions using random polynomials.
+ *   multiplyShiftHashFamily:
+ *      A family of 2-independent hash functions using Dietzfelbinger's
+ *      multiply-add-shift scheme, which needs no modulo at all.
+ *   mersenneThreeIndependentHashFamily:
+ *   mersenneFiveIndependentHashFamily:
+ *      Families of 3- and 5-independent hash functions using random
+ *      polynomials modulo the Mersenne prime 2^61 - 1, reduced with shifts
+ *      and additions rather than divisions.
  *   tabulationHashFamily:
  *      A family of 3-independent hash functions that are known to have
  *      excellent performance and theoretical guarantees stronger than
  *      their independence would normally imply. See "The Power of Simple
  *      Tabulation Hashing" by Patrascu and Thorup.
+ *   compactTabulationHashFamily:
+ *      The same family with 32-bit table entries, whose tables take half
+ *      the space.
  *   identityHash:
  *      A single hash function that's the identity function: h(x) = x.
  *   jenkinsHash:
  *      A single hash function that's known to, in practice, have nice
  *      statistical dispersion.
+ *
+ * Each family is a TypedHashFamily of the matching functor above, so any of
+ * them may be passed to a table templated on that functor. The families with
+ * more than one member take the seed of their generator.
  */
-std::shared_ptr<HashFamily> twoIndependentHashFamily();
-std::shared_ptr<HashFamily> threeIndependentHashFamily();
-std::shared_ptr<HashFamily> fiveIndependentHashFamily();
-std::shared_ptr<HashFamily> tabulationHashFamily();
+std::shared_ptr<HashFamily> twoIndependentHashFamily(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<HashFamily> threeIndependentHashFamily(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<HashFamily> fiveIndependentHashFamily(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<HashFamily> multiplyShiftHashFamily(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<HashFamily> mersenneThreeIndependentHashFamily(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<HashFamily> mersenneFiveIndependentHashFamily(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<HashFamily> tabulationHashFamily(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<HashFamily> compactTabulationHashFamily(uint64_t seed = kDefaultHashSeed);
 std::shared_ptr<HashFamily> identityHash();
 std::shared_ptr<HashFamily> jenkinsHash();
 
+/**
+ * Families for other key types.
+ *
+ *   tabulationHash64Family:
+ *      Simple tabulation hashing over the bytes of 64-bit keys.
+ *   wyHash64Family:
+ *      A wyhash-style multiply-and-fold mixer for 64-bit keys.
+ *   byteTabulationHashFamily:
+ *      Tabulation hashing over the bytes of a string.
+ *   wyStringHashFamily:
+ *      A wyhash-style mixer for strings, consuming sixteen bytes per
+ *      multiplication.
+ */
+std::shared_ptr<BasicHashFamily<uint64_t>> tabulationHash64Family(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<BasicHashFamily<uint64_t>> wyHash64Family(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<BasicHashFamily<std::string>> byteTabulationHashFamily(uint64_t seed = kDefaultHashSeed);
+std::shared_ptr<BasicHashFamily<std::string>> wyStringHashFamily(uint64_t seed = kDefaultHashSeed);
+
 #endif
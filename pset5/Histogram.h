@@ -0,0 +1,82 @@
+#ifndef Histogram_Included
+#define Histogram_Included
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A log-bucketed histogram of latencies in nanoseconds, in the style of
+ * HdrHistogram. Values below kSubBuckets are counted exactly; above that,
+ * every power of two is split into kSubBuckets equal buckets, so a value is
+ * only known to within 1 / kSubBuckets of itself (about 3%), however large.
+ * Recording is a few shifts and an increment, and the whole histogram is a
+ * couple of kilobytes, so it can take millions of samples.
+ */
+class LatencyHistogram {
+public:
+  static const int kSubBucketBits = 5;
+  static const uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+
+  LatencyHistogram() : counts((64 - kSubBucketBits + 1) * kSubBuckets, 0), total(0), largest(0) {}
+
+  void record(uint64_t value) {
+    counts[bucketFor(value)]++;
+    total++;
+    largest = std::max(largest, value);
+  }
+
+  uint64_t count() const {
+    return total;
+  }
+
+  uint64_t max() const {
+    return largest;
+  }
+
+  /**
+   * Returns the smallest value v such that at least a fraction p of all
+   * samples are no larger than v, give or take the bucket width. Returns the
+   * exact maximum for p = 1, and 0 if nothing was recorded.
+   */
+  uint64_t percentile(double p) const {
+    if (total == 0) return 0;
+    if (p >= 1) return largest;
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(p * total + 0.5));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < counts.size(); bucket++) {
+      seen += counts[bucket];
+      if (seen >= rank) return std::min(largest, highestIn(bucket));
+    }
+    return largest;
+  }
+
+private:
+  /* Values below kSubBuckets get a bucket each. A larger value with its top
+   * bit at position e goes to group e - kSubBucketBits + 1, and within it to
+   * the bucket given by the kSubBucketBits bits below the top one.
+   */
+  static size_t bucketFor(uint64_t value) {
+    if (value < kSubBuckets) return size_t(value);
+    int top = 63 - __builtin_clzll(value);
+    int shift = top - kSubBucketBits;
+    size_t group = size_t(shift + 1);
+    return group * kSubBuckets + size_t((value >> shift) - kSubBuckets);
+  }
+
+  /* The largest value that lands in the given bucket. */
+  static uint64_t highestIn(size_t bucket) {
+    size_t group = bucket / kSubBuckets;
+    uint64_t offset = bucket % kSubBuckets;
+    if (group == 0) return offset;
+    int shift = int(group) - 1;
+    return ((kSubBuckets + offset + 1) << shift) - 1;
+  }
+
+  std::vector<uint64_t> counts;
+  uint64_t total;
+  uint64_t largest;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef Keys_Included
+#define Keys_Included
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * How a table templated on its key type keeps keys in its slots. Every
+ * KeyTraits<Key> provides:
+ *
+ *    Slot                        what a slot holds for one key
+ *    store(key, hash)            a Slot for the key, whose hash is given
+ *    matches(slot, key, hash)    whether the slot holds the key
+ *    key(slot)                   the key the slot holds, for rehashing it
+ *    release(slot)               frees whatever store allocated
+ *
+ * A slot only holds a key between store and release; emptiness is tracked
+ * by the table, so no key value has to be reserved as a sentinel.
+ *
+ * Keys of a fixed size, like int and uint64_t, are kept in the slot itself.
+ */
+template <typename Key>
+struct KeyTraits {
+  typedef Key Slot;
+
+  static Slot store(const Key& key, size_t) {
+    return key;
+  }
+
+  static bool matches(const Slot& slot, const Key& key, size_t) {
+    return slot == key;
+  }
+
+  static Key key(const Slot& slot) {
+    return slot;
+  }
+
+  static void release(Slot&) {}
+};
+
+/**
+ * Strings are kept out of line. A slot holds a 32-bit fingerprint of the
+ * key's hash, the key's length and a pointer to a private copy of its bytes,
+ * 16 bytes in all, so a probe can rule out almost every non-matching key
+ * without following the pointer.
+ */
+template <>
+struct KeyTraits<std::string> {
+  struct Slot {
+    uint32_t fingerprint;
+    uint32_t length;
+    char* bytes;
+  };
+
+  static uint32_t fingerprint(size_t hash) {
+    return uint32_t(hash) ^ uint32_t(uint64_t(hash) >> 32);
+  }
+
+  static Slot store(const std::string& key, size_t hash) {
+    Slot slot;
+    slot.fingerprint = fingerprint(hash);
+    slot.length = uint32_t(key.size());
+    slot.bytes = new char[key.size()];
+    std::memcpy(slot.bytes, key.data(), key.size());
+    return slot;
+  }
+
+  static bool matches(const Slot& slot, const std::string& key, size_t hash) {
+    return slot.fingerprint == fingerprint(hash) && slot.length == key.size() &&
+           std::memcmp(slot.bytes, key.data(), key.size()) == 0;
+  }
+
+  static std::string key(const Slot& slot) {
+    return std::string(slot.bytes, slot.length);
+  }
+
+  static void release(Slot& slot) {
+    delete[] slot.bytes;
+  }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "LinearProbingHashMap.h"
+
+#include <stdexcept>
+
+static const int EMPTY = -1;
+static const size_t npos = size_t(-1);
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::BasicLinearProbingHashMap(size_t numBuckets, std::shared_ptr<HashFamily> family)
+{
+  this->hashFunction = sampleHash<Hash>(family);
+  this->capacity = Capacity(numBuckets);
+  this->buckets.assign(this->capacity.size(), EMPTY);
+  this->number_of_elements = 0;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::~BasicLinearProbingHashMap()
+{
+  // the storage's vectors clean up after themselves
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+bool BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::insert(int data, const Value& value)
+{
+  return place(data, value, false);
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+void BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::upsert(int data, const Value& value)
+{
+  place(data, value, true);
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+bool BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::place(int data, const Value& value, bool replace)
+{
+  if (data == EMPTY) throw std::invalid_argument("LinearProbingHashMap: -1 marks an empty bucket and can't be a key");
+  size_t index = this->index_for_data(data);
+  while (this->buckets.key(index) != EMPTY) {
+    if (this->buckets.key(index) == data) { // found data; don't insert duplicate
+      if (replace) this->buckets.value(index) = value;
+      return false;
+    }
+    index = this->capacity.next(index); // continue scanning
+  }
+  if (this->number_of_elements + 1 == this->buckets.size()) {
+    // a key in every bucket would leave nothing for a probe to stop at
+    throw std::length_error("LinearProbingHashMap: the last bucket must stay empty");
+  }
+  this->buckets.key(index) = data;
+  this->buckets.value(index) = value;
+  this->number_of_elements++;
+  return true;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+size_t BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::find_bucket(int data) const
+{
+  size_t index = this->index_for_data(data);
+  while (this->buckets.key(index) != EMPTY) {
+    if (this->buckets.key(index) == data) return index;
+    index = this->capacity.next(index);
+  }
+  return npos;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+Value* BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::find(int data)
+{
+  size_t index = this->find_bucket(data);
+  return index == npos ? nullptr : &this->buckets.value(index);
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+const Value* BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::find(int data) const
+{
+  size_t index = this->find_bucket(data);
+  return index == npos ? nullptr : &this->buckets.value(index);
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+void BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::remove(int data)
+{
+  size_t index = this->find_bucket(data);
+  if (index == npos) return;
+  this->number_of_elements--;
+  backward_shift(index);
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+size_t BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::size() const
+{
+  return this->number_of_elements;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+void BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::backward_shift(size_t hole)
+{
+  size_t index = this->capacity.next(hole);
+  while (this->buckets.key(index) != EMPTY) {
+    size_t home = this->index_for_data(this->buckets.key(index));
+    if (this->capacity.distance(home, index) >= this->capacity.distance(hole, index)) {
+      this->buckets.move(hole, index);
+      hole = index;
+    }
+    index = this->capacity.next(index);
+  }
+  this->buckets.key(hole) = EMPTY;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+size_t BasicLinearProbingHashMap<Hash, Capacity, Layout, Value>::index_for_data(int data) const
+{
+  size_t hash_value = this->hashFunction(data);
+  size_t index = this->capacity.index(hash_value);
+  return index;
+}
+
+#define INSTANTIATE_LAYOUT(Hash, Capacity, Layout)                             \
+  template class BasicLinearProbingHashMap<Hash, Capacity, Layout, int>;      \
+  template class BasicLinearProbingHashMap<Hash, Capacity, Layout, uint64_t>;
+#define INSTANTIATE(Hash, Capacity) FOR_EACH_LAYOUT(INSTANTIATE_LAYOUT, Hash, Capacity)
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
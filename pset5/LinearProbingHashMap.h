@@ -0,0 +1,102 @@
+#ifndef LinearProbingHashMap_Included
+#define LinearProbingHashMap_Included
+
+#include "Hashes.h"
+#include "Capacity.h"
+#include "MapLayout.h"
+
+#include <cstdint>
+
+/**
+ * A map from int keys to values of type Value, using linear probing. It is
+ * LinearProbingHashTable with a value next to every key: templated on the
+ * same Hash and Capacity, and removing with backward shifts, so no bucket is
+ * ever a tombstone.
+ *
+ * The Layout policy (see MapLayout.h) picks whether values sit inline next to
+ * their keys (InlineSlots) or in an array of their own (SeparateArrays).
+ * Value should be small and cheap to copy, since values move along with
+ * their keys.
+ *
+ * Like CuckooHashTable, -1 marks an empty bucket and can't be stored;
+ * insert and upsert throw std::invalid_argument when given it.
+ */
+template <typename Hash, typename Capacity = ModuloCapacity, typename Layout = InlineSlots, typename Value = int>
+class BasicLinearProbingHashMap {
+public:
+  typedef Value value_type;
+
+  /**
+   * Constructs a new linear probing map with the specified number of buckets,
+   * using hash functions drawn from the indicated family of hash functions.
+   * The map never changes its number of buckets.
+   */
+  BasicLinearProbingHashMap(size_t numBuckets, std::shared_ptr<HashFamily> family);
+
+  /**
+   * Cleans up all memory allocated by this map.
+   */
+  ~BasicLinearProbingHashMap();
+
+  /**
+   * Maps key to value, unless key is already present, in which case its value
+   * is left as it is. Returns whether key was inserted. As in
+   * LinearProbingHashTable, one bucket always stays empty, so adding a key
+   * that would fill the last one throws std::length_error.
+   */
+  bool insert(int key, const Value& value);
+
+  /**
+   * Maps key to value, replacing any value it had. Throws like insert.
+   */
+  void upsert(int key, const Value& value);
+
+  /**
+   * Returns a pointer to the value of key, or nullptr if key isn't present.
+   * The pointer stays valid until the next insert, upsert or remove.
+   */
+  Value* find(int key);
+  const Value* find(int key) const;
+
+  /**
+   * Removes key and its value from this map. If key is not present, this
+   * operation is a no-op.
+   */
+  void remove(int key);
+
+  /**
+   * Returns the number of keys in this map.
+   */
+  size_t size() const;
+
+private:
+  /* Returns the bucket holding key, or npos if there is none. */
+  size_t find_bucket(int key) const;
+
+  /* insert and upsert; 'replace' says whether to overwrite a present key. */
+  bool place(int key, const Value& value, bool replace);
+
+  /* Fills the hole at the given bucket, as LinearProbingHashTable does. */
+  void backward_shift(size_t hole);
+
+  size_t index_for_data(int data) const;
+
+  typename Layout::template Storage<int, Value> buckets;
+  size_t number_of_elements;
+  Capacity capacity;
+  Hash hashFunction;
+
+  /* Fun with C++: these next two lines disable implicitly-generated copy
+   * functions that would otherwise cause weird errors if you tried to
+   * implicitly copy an object of this type. You don't need to touch these
+   * lines.
+   */
+  BasicLinearProbingHashMap(BasicLinearProbingHashMap const &) = delete;
+  void operator=(BasicLinearProbingHashMap const &) = delete;
+};
+
+/* The type-erased maps, usable with every hash family. */
+template <typename Layout, typename Value = int>
+using LinearProbingHashMap = BasicLinearProbingHashMap<HashFunction, ModuloCapacity, Layout, Value>;
+
+#endif
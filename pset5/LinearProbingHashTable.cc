@@ -1,34 +1,71 @@
 #include <cassert>
+#include <algorithm>
+#include <stdexcept>
+#include <typeinfo>
+#include <vector>
 #include "LinearProbingHashTable.h"
 
 static int TOMBSTONE = -1;
 static int EMPTY = -2;
 
-LinearProbingHashTable::LinearProbingHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
+template <typename Hash, typename Capacity, typename Deletion>
+BasicLinearProbingHashTable<Hash, Capacity, Deletion>::BasicLinearProbingHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
 {
-  this->hashFunction = family->get();
-  this->buckets = std::vector<int>(numBuckets, EMPTY);
+  this->hashFunction = sampleHash<Hash>(family);
+  this->capacity = Capacity(numBuckets);
+  this->buckets = BucketArray<int>(this->capacity.size(), EMPTY);
+  this->number_of_elements = 0;
+  this->number_of_tombstones = 0;
 }
 
-LinearProbingHashTable::~LinearProbingHashTable()
+template <typename Hash, typename Capacity, typename Deletion>
+BasicLinearProbingHashTable<Hash, Capacity, Deletion>::~BasicLinearProbingHashTable()
 {
   // TODO: Implement this
 }
 
-void LinearProbingHashTable::insert(int data)
+template <typename Hash, typename Capacity, typename Deletion>
+void BasicLinearProbingHashTable<Hash, Capacity, Deletion>::insert(int data)
 {
-  size_t index = this->index_for_data(data);
+  insert_at(data, this->index_for_data(data));
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+void BasicLinearProbingHashTable<Hash, Capacity, Deletion>::insert_at(int data, size_t index)
+{
+  size_t tombstone = this->buckets.size();
   while (this->buckets[index] != EMPTY) {
     if (this->buckets[index] == data) return; // found data; don't insert duplicate
-    if (this->buckets[index] == TOMBSTONE) break; // found TOMBSTONE, insert here
+    if (this->buckets[index] == TOMBSTONE && tombstone == this->buckets.size()) {
+      tombstone = index; // remember the first TOMBSTONE, but keep looking for data
+    }
     index = next_index(index); // continue scanning
   }
+  if (this->number_of_elements + 1 == this->buckets.size()) {
+    // a key in every bucket would leave nothing for a probe to stop at
+    throw std::length_error("LinearProbingHashTable: the last bucket must stay empty");
+  }
+  if (tombstone != this->buckets.size()) { // reuse the TOMBSTONE
+    this->buckets[tombstone] = data;
+    this->number_of_tombstones--;
+    this->number_of_elements++;
+    return;
+  }
   this->buckets[index] = data;
+  this->number_of_elements++;
+  // filling an EMPTY bucket can leave tombstones outnumbering the rest
+  if (too_many_tombstones()) compact();
 }
 
-bool LinearProbingHashTable::contains(int data) const
+template <typename Hash, typename Capacity, typename Deletion>
+bool BasicLinearProbingHashTable<Hash, Capacity, Deletion>::contains(int data) const
+{
+  return contains_at(data, this->index_for_data(data));
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+bool BasicLinearProbingHashTable<Hash, Capacity, Deletion>::contains_at(int data, size_t index) const
 {
-  size_t index = this->index_for_data(data);
   while (this->buckets[index] != EMPTY) {
     if (this->buckets[index] == data) return true;
     index = this->next_index(index);
@@ -36,26 +73,229 @@ bool LinearProbingHashTable::contains(int data) const
   return false;
 }
 
-void LinearProbingHashTable::remove(int data)
+template <typename Hash, typename Capacity, typename Deletion>
+void BasicLinearProbingHashTable<Hash, Capacity, Deletion>::remove(int data)
 {
   size_t index = this->index_for_data(data);
   while(this->buckets[index] != EMPTY) {
     if(this->buckets[index] == data) {
-      this->buckets[index] = TOMBSTONE;
+      this->number_of_elements--;
+      if (Deletion::kBackwardShift) {
+        backward_shift(index);
+      } else {
+        this->buckets[index] = TOMBSTONE;
+        this->number_of_tombstones++;
+        if (too_many_tombstones()) compact();
+      }
       return;
     }
     index = next_index(index);
   }
 }
 
-size_t LinearProbingHashTable::next_index(size_t index) const
+template <typename Hash, typename Capacity, typename Deletion>
+void BasicLinearProbingHashTable<Hash, Capacity, Deletion>::contains_many(const int* keys, size_t n, bool* out) const
+{
+  size_t hashes[kBatchSize];
+  size_t indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction, keys + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = this->capacity.index(hashes[i]);
+      prefetch(&this->buckets[indices[i]]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      out[start + i] = contains_at(keys[start + i], indices[i]);
+    }
+  }
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+void BasicLinearProbingHashTable<Hash, Capacity, Deletion>::insert_many(const int* keys, size_t n)
+{
+  size_t hashes[kBatchSize];
+  size_t indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction, keys + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = this->capacity.index(hashes[i]);
+      prefetch(&this->buckets[indices[i]]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      insert_at(keys[start + i], indices[i]);
+    }
+  }
+}
+
+/**
+ * The counters are the element and tombstone counts; the buckets are saved
+ * as they are, tombstones included.
+ */
+template <typename Hash, typename Capacity, typename Deletion>
+void BasicLinearProbingHashTable<Hash, Capacity, Deletion>::save(const std::string& path) const
+{
+  if (!HashSerialization<Hash>::kSerializable) {
+    throw std::logic_error("Only tables with a concrete hash function can be saved.");
+  }
+  SnapshotContents contents;
+  contents.type = typeid(BasicLinearProbingHashTable).name();
+  contents.hash = &this->hashFunction;
+  contents.hash_bytes = sizeof(Hash);
+  contents.counters = {this->number_of_elements, this->number_of_tombstones};
+  contents.buckets = this->buckets.data();
+  contents.bucket_count = this->buckets.size();
+  contents.bucket_bytes = sizeof(int);
+  writeSnapshot(path, contents);
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+std::unique_ptr<BasicLinearProbingHashTable<Hash, Capacity, Deletion>>
+BasicLinearProbingHashTable<Hash, Capacity, Deletion>::load(const std::string& path, bool verify)
+{
+  if (!HashSerialization<Hash>::kSerializable) {
+    throw std::logic_error("Only tables with a concrete hash function can be loaded.");
+  }
+  LoadedSnapshot snapshot = readSnapshot(path, typeid(BasicLinearProbingHashTable).name(), sizeof(Hash),
+                                         sizeof(int), verify);
+  if (snapshot.counters.size() != 2) throw std::runtime_error("Snapshot " + path + " has the wrong counters");
+
+  std::unique_ptr<BasicLinearProbingHashTable> table(new BasicLinearProbingHashTable());
+  table->hashFunction = readHash<Hash>(snapshot.hash);
+  table->capacity = Capacity(snapshot.bucket_count);
+  table->buckets = BucketArray<int>(snapshot.file, static_cast<int*>(snapshot.buckets), snapshot.bucket_count);
+  table->number_of_elements = snapshot.counters[0];
+  table->number_of_tombstones = snapshot.counters[1];
+  return table;
+}
+
+/**
+ * Fills the hole at the given index by moving later elements of its cluster
+ * back, as long as that doesn't move them before their home location.
+ */
+template <typename Hash, typename Capacity, typename Deletion>
+void BasicLinearProbingHashTable<Hash, Capacity, Deletion>::backward_shift(size_t hole)
+{
+  size_t index = next_index(hole);
+  while (this->buckets[index] != EMPTY) {
+    size_t home = this->index_for_data(this->buckets[index]);
+    if (this->capacity.distance(home, index) >= this->capacity.distance(hole, index)) {
+      this->buckets[hole] = this->buckets[index];
+      hole = index;
+    }
+    index = next_index(index);
+  }
+  this->buckets[hole] = EMPTY;
+}
+
+/* Tombstones are cleared once they outnumber the truly EMPTY buckets. Since
+ * both insert and remove check, a table with a tombstone always has an EMPTY
+ * bucket for every probe to stop at.
+ */
+template <typename Hash, typename Capacity, typename Deletion>
+bool BasicLinearProbingHashTable<Hash, Capacity, Deletion>::too_many_tombstones() const
 {
-  return ++index % this->buckets.size();
+  return 2 * this->number_of_tombstones > this->buckets.size() - this->number_of_elements;
+}
+
+/**
+ * Removes all tombstones without allocating. Starting just after a bucket
+ * that was EMPTY before any tombstone was cleared (so no cluster wraps past
+ * it), every element is taken out and reinserted in turn. An element only
+ * ever moves back towards its home location, and everything before it has
+ * already been settled, so one pass around the table suffices.
+ *
+ * If insertions used up the last EMPTY bucket, there is no such starting
+ * point, and the table is rebuilt from a copy of its keys instead.
+ */
+template <typename Hash, typename Capacity, typename Deletion>
+void BasicLinearProbingHashTable<Hash, Capacity, Deletion>::compact()
+{
+  size_t start = 0;
+  while (start < this->buckets.size() && this->buckets[start] != EMPTY) start++;
+
+  if (start == this->buckets.size()) {
+    std::vector<int> keys;
+    for (auto& bucket : this->buckets) {
+      if (bucket != TOMBSTONE) keys.push_back(bucket);
+      bucket = EMPTY;
+    }
+    this->number_of_tombstones = 0;
+    for (int data : keys) {
+      size_t target = this->index_for_data(data);
+      while (this->buckets[target] != EMPTY) {
+        target = next_index(target);
+      }
+      this->buckets[target] = data;
+    }
+    return;
+  }
+
+  for (auto& bucket : this->buckets) {
+    if (bucket == TOMBSTONE) bucket = EMPTY;
+  }
+  this->number_of_tombstones = 0;
+
+  size_t index = start;
+  for (size_t count = 0; count < this->buckets.size(); count++) {
+    index = next_index(index);
+    int data = this->buckets[index];
+    if (data == EMPTY) continue;
+
+    this->buckets[index] = EMPTY;
+    size_t target = this->index_for_data(data);
+    while (this->buckets[target] != EMPTY) {
+      target = next_index(target);
+    }
+    this->buckets[target] = data;
+  }
 }
 
-size_t LinearProbingHashTable::index_for_data(int data) const
+template <typename Hash, typename Capacity, typename Deletion>
+size_t BasicLinearProbingHashTable<Hash, Capacity, Deletion>::size() const
+{
+  return this->number_of_elements;
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+size_t BasicLinearProbingHashTable<Hash, Capacity, Deletion>::slot_count() const
+{
+  return this->buckets.size();
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+bool BasicLinearProbingHashTable<Hash, Capacity, Deletion>::key_at(size_t slot, int& key) const
+{
+  key = this->buckets[slot];
+  return key != EMPTY && key != TOMBSTONE;
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+size_t BasicLinearProbingHashTable<Hash, Capacity, Deletion>::migration_anchor() const
+{
+  for (size_t index = 0; index < this->buckets.size(); index++) {
+    if (this->buckets[index] == EMPTY) return index;
+  }
+  return 0; // a full table; no removal can shift keys anyway without a hole
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+size_t BasicLinearProbingHashTable<Hash, Capacity, Deletion>::next_index(size_t index) const
+{
+  return this->capacity.next(index);
+}
+
+template <typename Hash, typename Capacity, typename Deletion>
+size_t BasicLinearProbingHashTable<Hash, Capacity, Deletion>::index_for_data(int data) const
 {
   size_t hash_value = this->hashFunction(data);
-  size_t index = hash_value % this->buckets.size();
+  size_t index = this->capacity.index(hash_value);
   return index;
 }
+
+#define INSTANTIATE(Hash, Capacity)                                                   \
+  template class BasicLinearProbingHashTable<Hash, Capacity, TombstoneDeletion>;     \
+  template class BasicLinearProbingHashTable<Hash, Capacity, BackwardShiftDeletion>;
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
@@ -2,10 +2,37 @@
 #define LinearProbingHashTable_Included
 
 #include "Hashes.h"
+#include "Capacity.h"
+#include "Batch.h"
+#include "Snapshot.h"
 
-#include <vector>
+#include <memory>
+#include <string>
 
-class LinearProbingHashTable {
+/**
+ * The table is templated on the type of its hash function. With Hash =
+ * HashFunction it accepts any HashFamily; with one of the concrete hashers
+ * from Hashes.h (e.g. TabulationHash) it must be given the matching family,
+ * and the hash is inlined into every probe.
+ *
+ * The Capacity policy (see Capacity.h) decides how hashes are mapped onto
+ * buckets. The default, ModuloCapacity, keeps the requested bucket count;
+ * PowerOfTwoCapacity and FastRangeCapacity trade exactness or hash quality
+ * requirements for cheaper index arithmetic.
+ *
+ * The Deletion policy picks how remove works: TombstoneDeletion (the default)
+ * or BackwardShiftDeletion, both described at remove() below.
+ */
+struct TombstoneDeletion {
+  static const bool kBackwardShift = false;
+};
+
+struct BackwardShiftDeletion {
+  static const bool kBackwardShift = true;
+};
+
+template <typename Hash, typename Capacity = ModuloCapacity, typename Deletion = TombstoneDeletion>
+class BasicLinearProbingHashTable {
 public:
   /**
    * Constructs a new linear probing table with the specified number of buckets,
@@ -15,22 +42,24 @@ public:
    * table has initially be created.
    *
    * You can choose a hash function out of the family of hash functions by
-   * declaring a variable of type HashFunction and assigning it the value
-   * family->get(). For example:
+   * declaring a variable of type Hash and assigning it the value
+   * sampleHash<Hash>(family). For example:
    *
-   *    HashFunction h;
-   *    h = family->get();
+   *    Hash h;
+   *    h = sampleHash<Hash>(family);
    */
-  LinearProbingHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+  BasicLinearProbingHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
   
   /**
    * Cleans up all memory allocated by this hash table.
    */
-  ~LinearProbingHashTable();
+  ~BasicLinearProbingHashTable();
   
   /**
    * Inserts the specified element into this hash table. If the element already
-   * exists, this operation is a no-op.
+   * exists, this operation is a no-op. At least one bucket is always kept
+   * free, so that every probe ends: inserting a key into a table whose other
+   * buckets all hold keys throws std::length_error.
    */
   void insert(int key);
   
@@ -46,23 +75,92 @@ public:
    * You should implement this operation using tombstone deletion - replace the
    * key to remove with a special "tombstone" value indicating that something
    * that was stored here has since been removed.
+   *
+   * Tombstones are reused by later insertions, and once they make up more
+   * than half of the buckets that hold no key, whether after a removal or
+   * after an insertion into an EMPTY bucket, the table is compacted in place
+   * so that lookups for missing keys stay short under churn.
+   *
+   * With BackwardShiftDeletion no tombstones are written at all: the elements
+   * after the removed one are shifted back into the hole as far as their home
+   * locations allow, as in RobinHoodHashTable::remove.
    */
   void remove(int key);
 
+  /**
+   * Batched lookup: sets out[i] to contains(keys[i]) for every i < n. The
+   * home buckets of a whole batch of keys are prefetched before any of them
+   * is probed (see Batch.h).
+   */
+  void contains_many(const int* keys, size_t n, bool* out) const;
+
+  /**
+   * Inserts keys[0], ..., keys[n - 1], prefetching their home buckets a batch
+   * at a time in the same way.
+   */
+  void insert_many(const int* keys, size_t n);
+
+  /**
+   * Snapshots (see Snapshot.h). save() writes this table's buckets, counters
+   * and hash function to path; load() maps such a file back in as a new
+   * table without reinserting anything. With verify set, load() checks the
+   * file's checksum first, at the cost of reading all of it.
+   *
+   * Only tables with a concrete hasher (e.g. TabulationHash) can be saved or
+   * loaded; for the type-erased HashFunction both throw std::logic_error.
+   * Other failures throw std::runtime_error.
+   */
+  void save(const std::string& path) const;
+  static std::unique_ptr<BasicLinearProbingHashTable> load(const std::string& path, bool verify = true);
+
+  /**
+   * Access for GrowableHashTable, which moves the keys of a full table into a
+   * larger one a few buckets at a time: size() is the number of keys stored,
+   * and key_at() says whether bucket 'slot' holds a key, and which.
+   *
+   * While a table is being drained it only sees removals. Those only move
+   * keys backwards within their cluster, and clusters end at empty buckets,
+   * so migration_anchor() returns an empty bucket that no key moves past.
+   */
+  size_t size() const;
+  size_t slot_count() const;
+  bool key_at(size_t slot, int& key) const;
+  size_t migration_anchor() const;
+
+  /* The load factor above which GrowableHashTable grows the table. */
+  static constexpr double kMaxLoadFactor = 0.7;
+
   size_t index_for_data(int data) const;
   size_t next_index(size_t index) const;
   
 private:
-  std::vector<int> buckets;
-  HashFunction hashFunction;
+  /* An empty shell for load() to fill in. */
+  BasicLinearProbingHashTable() = default;
+
+  /* contains and insert, given the home bucket of data. */
+  bool contains_at(int data, size_t index) const;
+  void insert_at(int data, size_t index);
+
+  void backward_shift(size_t index);
+  bool too_many_tombstones() const;
+  void compact();
+
+  BucketArray<int> buckets;
+  size_t number_of_elements;
+  size_t number_of_tombstones;
+  Capacity capacity;
+  Hash hashFunction;
   
   /* Fun with C++: these next two lines disable implicitly-generated copy
    * functions that would otherwise cause weird errors if you tried to
    * implicitly copy an object of this type. You don't need to touch these
    * lines.
    */
-  LinearProbingHashTable(LinearProbingHashTable const &) = delete;
-  void operator=(LinearProbingHashTable const &) = delete;
+  BasicLinearProbingHashTable(BasicLinearProbingHashTable const &) = delete;
+  void operator=(BasicLinearProbingHashTable const &) = delete;
 };
 
+/* The type-erased table, usable with every hash family. */
+using LinearProbingHashTable = BasicLinearProbingHashTable<HashFunction>;
+
 #endif
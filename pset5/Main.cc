@@ -1,14 +1,42 @@
 #include <iostream>
+#include <string>
 
 #include "Hashes.h"
 #include "ChainedHashTable.h"
 #include "SecondChoiceHashTable.h"
+#include "MultipleChoiceHashTable.h"
 #include "LinearProbingHashTable.h"
 #include "RobinHoodHashTable.h"
+#include "SwissHashTable.h"
+#include "LinearProbingHashMap.h"
+#include "RobinHoodHashMap.h"
 #include "CuckooHashTable.h"
+#include "BucketizedCuckooHashTable.h"
+#include "GrowableHashTable.h"
+#include "ConcurrentLinearProbingHashTable.h"
+#include "ConcurrentCuckooHashTable.h"
+#include "Workloads.h"
 #include "Timing.h"
 
-int main() {
+/* run-tests [--csv file | --json file] also writes every timing result to
+ * the given file (see Results.h). With --counters, the timings that count
+ * their operations also print hardware counters (see PerfCounters.h).
+ */
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string flag = argv[i];
+    if ((flag == "--csv" || flag == "--json") && i + 1 < argc) {
+      ResultLog::current().open(argv[++i], flag == "--csv" ? ResultLog::Format::CSV : ResultLog::Format::JSON);
+    } else if (flag == "--counters") {
+      if (!PerfCounters::current().enable()) {
+        std::cerr << "Hardware counters unavailable (" << PerfCounters::current().reason() << ")" << std::endl;
+      }
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--csv file | --json file] [--counters]" << std::endl;
+      return 1;
+    }
+  }
+
   /* A list of all true families of hash functions (that is, hash families
    * where we can sample as many hash functions as we need.) These hash
    * families can be used in any hash table type.
@@ -17,7 +45,11 @@ int main() {
     twoIndependentHashFamily(),
     threeIndependentHashFamily(),
     fiveIndependentHashFamily(),
-    tabulationHashFamily()
+    multiplyShiftHashFamily(),
+    mersenneThreeIndependentHashFamily(),
+    mersenneFiveIndependentHashFamily(),
+    tabulationHashFamily(),
+    compactTabulationHashFamily()
   };
   
   /* A list of all types of hash functions available, including families with
@@ -28,51 +60,383 @@ int main() {
     twoIndependentHashFamily(),
     threeIndependentHashFamily(),
     fiveIndependentHashFamily(),
+    multiplyShiftHashFamily(),
+    mersenneThreeIndependentHashFamily(),
+    mersenneFiveIndependentHashFamily(),
     tabulationHashFamily(),
+    compactTabulationHashFamily(),
     identityHash(),
     jenkinsHash()
   };
 
+  /* Families for the tables with 64-bit and with string keys. */
+  auto uint64HashFamilies = {tabulationHash64Family(), wyHash64Family()};
+  auto stringHashFamilies = {byteTabulationHashFamily(), wyStringHashFamily()};
+
   std::cout << "Correctness Tests" << std::endl;
+  std::cout << "  Hash Seeding:   " << (checkSeeding({twoIndependentHashFamily, threeIndependentHashFamily, fiveIndependentHashFamily,
+                                                        multiplyShiftHashFamily, mersenneThreeIndependentHashFamily,
+                                                        mersenneFiveIndependentHashFamily, tabulationHashFamily,
+                                                        compactTabulationHashFamily}) ? "pass" : "fail") << std::endl;
   std::cout << "  Chained:        " << (checkCorrectness<ChainedHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
   std::cout << "  Second-Choice:  " << (checkCorrectness<SecondChoiceHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  d-Choice:       " << (checkCorrectness<MultipleChoiceHashTable<2>>(allHashFamilies) &&
+                                          checkCorrectness<MultipleChoiceHashTable<3>>(allHashFamilies) &&
+                                          checkCorrectness<MultipleChoiceHashTable<4>>(allHashFamilies) &&
+                                          checkCorrectness<MultipleChoiceHashTable<2>>({std::make_tuple(4, tabulationHashFamily(), 1000)}) ? "pass" : "fail") << std::endl;
   std::cout << "  Linear Probing: " << (checkCorrectness<LinearProbingHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  Backward Shift: " << (checkCorrectness<BasicLinearProbingHashTable<HashFunction, ModuloCapacity, BackwardShiftDeletion>>(allHashFamilies) ? "pass" : "fail") << std::endl;
   std::cout << "  Robin Hood:     " << (checkCorrectness<RobinHoodHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  Maps:           " << (checkMapCorrectness<LinearProbingHashMap<InlineSlots>>(allHashFunctions) &&
+                                          checkMapCorrectness<LinearProbingHashMap<SeparateArrays, uint64_t>>(allHashFunctions) &&
+                                          checkMapRejectsKey<LinearProbingHashMap<InlineSlots>>(-1, allHashFunctions) &&
+                                          checkMapCorrectness<RobinHoodHashMap<InlineSlots, uint64_t>>(allHashFunctions) &&
+                                          checkMapCorrectness<RobinHoodHashMap<SeparateArrays>>(allHashFunctions) ? "pass" : "fail") << std::endl;
+  std::cout << "  Snapshots:      " << (checkSnapshot<BasicLinearProbingHashTable<TabulationHash>>({tabulationHashFamily()}) &&
+                                          checkSnapshot<BasicLinearProbingHashTable<JenkinsHash, PowerOfTwoCapacity, BackwardShiftDeletion>>({jenkinsHash()}) &&
+                                          checkSnapshot<BasicRobinHoodHashTable<TabulationHash>>({tabulationHashFamily()}) &&
+                                          checkSnapshot<BasicRobinHoodHashTable<MultiplyShiftHash, FastRangeCapacity>>({multiplyShiftHashFamily()}) ? "pass" : "fail") << std::endl;
+  std::cout << "  Swiss:          " << (checkCorrectness<SwissHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  Swiss (uint64): " << (checkKeyedCorrectness<Uint64SwissHashTable>(uint64HashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  Swiss (string): " << (checkKeyedCorrectness<StringSwissHashTable>(stringHashFamilies) &&
+                                          checkKeyedCorrectness<BasicSwissHashTable<WyStringHash, ModuloCapacity, std::string>>({wyStringHashFamily()}) ? "pass" : "fail") << std::endl;
   std::cout << "  Cuckoo:         " << (checkCorrectness<CuckooHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  Cuckoo (BFS):   " << (checkCorrectness<BasicCuckooHashTable<HashFunction, ModuloCapacity, BreadthFirstInsertion>>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  (2, 4)-Cuckoo:  " << (checkCorrectness<BucketizedCuckooHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  Churn:          " << (checkChurn<LinearProbingHashTable>(allHashFunctions) &&
+                                          checkChurn<BasicLinearProbingHashTable<HashFunction, ModuloCapacity, BackwardShiftDeletion>>(allHashFunctions) &&
+                                          checkChurn<RobinHoodHashTable>(allHashFunctions) &&
+                                          checkChurn<SwissHashTable>(allHashFunctions) ? "pass" : "fail") << std::endl;
+  std::cout << "  Batched:        " << (checkBatchCorrectness<ChainedHashTable>(allHashFamilies) &&
+                                          checkBatchCorrectness<SecondChoiceHashTable>(allHashFamilies) &&
+                                          checkBatchCorrectness<MultipleChoiceHashTable<3>>(allHashFamilies) &&
+                                          checkBatchCorrectness<LinearProbingHashTable>(allHashFamilies) &&
+                                          checkBatchCorrectness<RobinHoodHashTable>(allHashFamilies) &&
+                                          checkBatchCorrectness<SwissHashTable>(allHashFamilies) &&
+                                          checkBatchCorrectness<CuckooHashTable>(allHashFamilies) &&
+                                          checkBatchCorrectness<BucketizedCuckooHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  Workloads:      " << (checkWorkloads<LinearProbingHashTable>(standardWorkloads(), {tabulationHashFamily(), identityHash()}) &&
+                                          checkWorkloads<RobinHoodHashTable>(standardWorkloads(), {tabulationHashFamily(), identityHash()}) &&
+                                          checkWorkloads<ChainedHashTable>(standardWorkloads(), {tabulationHashFamily(), identityHash()}) &&
+                                          checkWorkloads<SecondChoiceHashTable>(standardWorkloads(), {tabulationHashFamily()}) &&
+                                          checkWorkloads<CuckooHashTable>(standardWorkloads(), {tabulationHashFamily()}) ? "pass" : "fail") << std::endl;
+  std::cout << "  Growing Linear: " << (checkGrowth<GrowableHashTable<LinearProbingHashTable>>(allHashFunctions) ? "pass" : "fail") << std::endl;
+  std::cout << "  Growing Shift:  " << (checkGrowth<GrowableHashTable<BasicLinearProbingHashTable<HashFunction, ModuloCapacity, BackwardShiftDeletion>>>(allHashFunctions) ? "pass" : "fail") << std::endl;
+  std::cout << "  Growing Robin:  " << (checkGrowth<GrowableHashTable<RobinHoodHashTable>>(allHashFunctions) ? "pass" : "fail") << std::endl;
+  std::cout << "  Growing Cuckoo: " << (checkGrowth<GrowableHashTable<CuckooHashTable>>(allHashFamilies) ? "pass" : "fail") << std::endl;
+  std::cout << "  Concurrent LP:  " << (checkCorrectness<ConcurrentLinearProbingHashTable>(allHashFunctions) &&
+                                          checkConcurrentCorrectness<ConcurrentLinearProbingHashTable>(allHashFunctions) &&
+                                          checkConcurrentChurn<ConcurrentLinearProbingHashTable>(allHashFunctions) ? "pass" : "fail") << std::endl;
+  std::cout << "  Seqlock Cuckoo: " << (checkCorrectness<ConcurrentCuckooHashTable>(allHashFamilies) &&
+                                          checkConcurrentCorrectness<ConcurrentCuckooHashTable>(allHashFamilies) &&
+                                          checkConcurrentChurn<ConcurrentCuckooHashTable>(allHashFamilies) ? "pass" : "fail") << std::endl;
   std::cout << std::endl;
 
   /* Test linear probing variants. */
   auto probingLoadFactors = {0.3, 0.5, 0.7, 0.9, 0.99};
 
-  std::cout << "#### Timing Linear Probing ####" << std::endl;
+  printSection("Timing Linear Probing");
   doAllReports<LinearProbingHashTable>(allHashFunctions, probingLoadFactors);
   std::cout << "###########################" << std::endl;
   std::cout << std::endl;
+
+  printSection("Timing Linear Probing (Backward Shift)");
+  doAllReports<BasicLinearProbingHashTable<HashFunction, ModuloCapacity, BackwardShiftDeletion>>(allHashFunctions, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
   
-  std::cout << "#### Timing Robin Hood ####" << std::endl;
+  printSection("Timing Robin Hood");
   doAllReports<RobinHoodHashTable>(allHashFunctions, probingLoadFactors);
   std::cout << "###########################" << std::endl;
   std::cout << std::endl;
+
+  printSection("Timing Swiss");
+  doAllReports<SwissHashTable>(allHashFunctions, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Maps with 8-byte values, stored inline or in an array of their own. */
+  printSection("Timing Linear Probing Map (Inline Values)");
+  doAllReports<MapAsSet<LinearProbingHashMap<InlineSlots, uint64_t>>>(allHashFunctions, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing Linear Probing Map (Separate Values)");
+  doAllReports<MapAsSet<LinearProbingHashMap<SeparateArrays, uint64_t>>>(allHashFunctions, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing Robin Hood Map (Inline Values)");
+  doAllReports<MapAsSet<RobinHoodHashMap<InlineSlots, uint64_t>>>(allHashFunctions, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing Robin Hood Map (Separate Values)");
+  doAllReports<MapAsSet<RobinHoodHashMap<SeparateArrays, uint64_t>>>(allHashFunctions, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing Swiss (64-bit Keys)");
+  doKeyedReports<Uint64SwissHashTable>(uint64HashFamilies, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing Swiss (String Keys)");
+  doKeyedReports<StringSwissHashTable>(stringHashFamilies, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
   
   
   /* Test chained hashing variants. */
   auto chainedLoadFactors = {0.3, 0.5, 0.7, 0.9, 0.99, 2.0, 5.00};
   
-  std::cout << "#### Timing Chained ####" << std::endl;
+  printSection("Timing Chained");
   doAllReports<ChainedHashTable>(allHashFunctions, chainedLoadFactors);
   std::cout << "###########################" << std::endl;
   std::cout << std::endl;
   
-  std::cout << "#### Timing Second-Choice ####" << std::endl;
+  printSection("Timing Second-Choice");
   doAllReports<SecondChoiceHashTable>(allHashFamilies, chainedLoadFactors);
   std::cout << "###########################" << std::endl;
   std::cout << std::endl;
+
+  /* The same with inline buckets of one cache line each, and d choices. */
+  printSection("Timing d-Choice (d = 2)");
+  doAllReports<MultipleChoiceHashTable<2>>(allHashFamilies, chainedLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing d-Choice (d = 3)");
+  doAllReports<MultipleChoiceHashTable<3>>(allHashFamilies, chainedLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
   
   /* Test cuckoo hashing. */
   auto cuckooLoadFactors = {0.2, 0.3, 0.4, 0.45, 0.47};
 
-  std::cout << "#### Timing Cuckoo Hashing ####" << std::endl;
-  doAllReports<CuckooHashTable>(allHashFamilies, cuckooLoadFactors);
+  printSection("Timing Cuckoo Hashing");
+  doStashReports<CuckooHashTable>(allHashFamilies, cuckooLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing Cuckoo Hashing (BFS Insertion)");
+  doStashReports<BasicCuckooHashTable<HashFunction, ModuloCapacity, BreadthFirstInsertion>>(allHashFamilies, cuckooLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Bucketized cuckoo hashing supports much higher load factors. */
+  auto bucketizedCuckooLoadFactors = {0.3, 0.5, 0.7, 0.9, 0.95};
+
+  printSection("Timing (2, 4)-Cuckoo Hashing");
+  doAllReports<BucketizedCuckooHashTable>(allHashFamilies, bucketizedCuckooLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Growable tables, filled without knowing the number of keys up front. */
+  printSection("Timing Growable Linear Probing");
+  doGrowthReports<GrowableHashTable<LinearProbingHashTable>>(allHashFunctions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing Growable Robin Hood");
+  doGrowthReports<GrowableHashTable<RobinHoodHashTable>>(allHashFunctions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Timing Growable Cuckoo Hashing");
+  doGrowthReports<GrowableHashTable<CuckooHashTable>>(allHashFamilies);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Batched lookups and insertions against one key at a time, on tables
+   * large enough not to fit in the last-level cache.
+   */
+  const size_t batchActions = 1 << 22;
+  auto batchHashFamilies = {tabulationHashFamily(), compactTabulationHashFamily()};
+
+  printSection("Hash Functions");
+  doHashingReports(batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Batched: Chained");
+  doBatchReports<ChainedHashTable>(batchHashFamilies, chainedLoadFactors, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Batched: Second-Choice");
+  doBatchReports<SecondChoiceHashTable>(batchHashFamilies, chainedLoadFactors, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Batched: d-Choice (d = 2)");
+  doBatchReports<MultipleChoiceHashTable<2>>(batchHashFamilies, chainedLoadFactors, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Batched: Linear Probing");
+  doBatchReports<LinearProbingHashTable>(batchHashFamilies, probingLoadFactors, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Batched: Robin Hood");
+  doBatchReports<RobinHoodHashTable>(batchHashFamilies, probingLoadFactors, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Batched: Swiss");
+  doBatchReports<SwissHashTable>(batchHashFamilies, probingLoadFactors, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Batched: Cuckoo Hashing");
+  doBatchReports<CuckooHashTable>(batchHashFamilies, cuckooLoadFactors, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Batched: (2, 4)-Cuckoo Hashing");
+  doBatchReports<BucketizedCuckooHashTable>(batchHashFamilies, bucketizedCuckooLoadFactors, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Throughput and tail latencies, from operations timed in bulk and from a
+   * sample of single operations.
+   */
+  const size_t latencyActions = 1 << 20;
+  auto latencyHashFamilies = {tabulationHashFamily(), jenkinsHash()};
+
+  printSection("Latency: Chained");
+  doLatencyReports<ChainedHashTable>(latencyHashFamilies, chainedLoadFactors, latencyActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Latency: d-Choice (d = 2)");
+  doLatencyReports<MultipleChoiceHashTable<2>>(latencyHashFamilies, chainedLoadFactors, latencyActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Latency: Linear Probing");
+  doLatencyReports<LinearProbingHashTable>(latencyHashFamilies, probingLoadFactors, latencyActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Latency: Robin Hood");
+  doLatencyReports<RobinHoodHashTable>(latencyHashFamilies, probingLoadFactors, latencyActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Latency: Swiss");
+  doLatencyReports<SwissHashTable>(latencyHashFamilies, probingLoadFactors, latencyActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Latency: Cuckoo Hashing");
+  doLatencyReports<CuckooHashTable>(latencyHashFamilies, cuckooLoadFactors, latencyActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Skewed, sequential and strided keys, queries with a given hit ratio and
+   * tables under churn (see Workloads.h). identityHash is only fit for the
+   * tables that need a single hash function.
+   */
+  const size_t workloadActions = 100000;
+  auto workloads = standardWorkloads();
+  auto workloadHashFunctions = {tabulationHashFamily(), multiplyShiftHashFamily(), jenkinsHash(), identityHash()};
+  auto workloadHashFamilies = {tabulationHashFamily(), multiplyShiftHashFamily()};
+
+  printSection("Workloads: Linear Probing");
+  doWorkloadReports<LinearProbingHashTable>(workloads, workloadHashFunctions, {0.5, 0.9}, workloadActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Workloads: Robin Hood");
+  doWorkloadReports<RobinHoodHashTable>(workloads, workloadHashFunctions, {0.5, 0.9}, workloadActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Workloads: Chained");
+  doWorkloadReports<ChainedHashTable>(workloads, workloadHashFunctions, {0.9, 2.0}, workloadActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Workloads: Second-Choice");
+  doWorkloadReports<SecondChoiceHashTable>(workloads, workloadHashFamilies, {0.9, 2.0}, workloadActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Workloads: Cuckoo Hashing");
+  doWorkloadReports<CuckooHashTable>(workloads, workloadHashFamilies, {0.3, 0.45}, workloadActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Starting up with a large table: rebuilding it, or loading a snapshot. */
+  printSection("Snapshots: Linear Probing");
+  doSnapshotReports<BasicLinearProbingHashTable<TabulationHash>>({tabulationHashFamily()}, {0.5, 0.9}, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Snapshots: Robin Hood");
+  doSnapshotReports<BasicRobinHoodHashTable<TabulationHash>>({tabulationHashFamily()}, {0.5, 0.9}, batchActions);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* A read-heavy mix on a table shared by more and more threads. */
+  std::initializer_list<size_t> threadCounts = {1, 2, 4, 8};
+
+  printSection("Threads: Concurrent Linear Probing");
+  doThreadReports<ConcurrentLinearProbingHashTable>(allHashFunctions, probingLoadFactors, threadCounts, 0.05);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Threads: Concurrent Cuckoo Hashing (95% reads)");
+  doThreadReports<ConcurrentCuckooHashTable>(allHashFamilies, cuckooLoadFactors, threadCounts, 0.05);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Threads: Concurrent Cuckoo Hashing (50% reads)");
+  doThreadReports<ConcurrentCuckooHashTable>(allHashFamilies, cuckooLoadFactors, threadCounts, 0.5);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Compare bucket indexing policies on the open-addressing tables. */
+  printSection("Capacity Policies: Linear Probing");
+  doCapacityReports<BasicLinearProbingHashTable>(allHashFamilies, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Capacity Policies: Robin Hood");
+  doCapacityReports<BasicRobinHoodHashTable>(allHashFamilies, probingLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Capacity Policies: Cuckoo Hashing");
+  doCapacityReports<BasicCuckooHashTable>(allHashFamilies, cuckooLoadFactors);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  /* Compare type-erased hash functions against inlined concrete hashers. */
+  printSection("Hash Dispatch: Linear Probing");
+  doHashDispatchReports<BasicLinearProbingHashTable>(probingLoadFactors, true);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Hash Dispatch: Robin Hood");
+  doHashDispatchReports<BasicRobinHoodHashTable>(probingLoadFactors, true);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Hash Dispatch: Chained");
+  doHashDispatchReports<BasicChainedHashTable>(chainedLoadFactors, true);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Hash Dispatch: Second-Choice");
+  doHashDispatchReports<BasicSecondChoiceHashTable>(chainedLoadFactors, false);
+  std::cout << "###########################" << std::endl;
+  std::cout << std::endl;
+
+  printSection("Hash Dispatch: Cuckoo Hashing");
+  doHashDispatchReports<BasicCuckooHashTable>(cuckooLoadFactors, false);
   std::cout << "###########################" << std::endl;
   std::cout << std::endl;
 }
@@ -0,0 +1,93 @@
+#ifndef MapLayout_Included
+#define MapLayout_Included
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Slot layouts for the hash maps. For every slot a map keeps a key part (the
+ * key, plus whatever else the map probes on, like a probe distance) and a
+ * value. The Layout policy decides where the two live:
+ *
+ *   InlineSlots      key part and value side by side in a single array, so
+ *                    a hit finds its value in the cache line it probed.
+ *   SeparateArrays   key parts in one array and values in another (a
+ *                    structure of arrays), so probes scan densely packed
+ *                    keys and only touch a value on a hit.
+ *
+ * Each policy provides a class template Storage<KeyPart, Value> with
+ *
+ *    assign(n, empty)   makes n slots whose key parts are all 'empty'
+ *    size()             the number of slots
+ *    key(i), value(i)   references to the two parts of slot i
+ *    move(to, from)     copies slot 'from' over slot 'to'
+ *    key_address(i)     what to prefetch to probe slot i
+ */
+struct InlineSlots {
+  template <typename KeyPart, typename Value>
+  class Storage {
+  public:
+    void assign(size_t n, const KeyPart& empty) {
+      slots.assign(n, Slot{empty, Value()});
+    }
+
+    size_t size() const { return slots.size(); }
+
+    KeyPart& key(size_t i) { return slots[i].key; }
+    const KeyPart& key(size_t i) const { return slots[i].key; }
+    Value& value(size_t i) { return slots[i].value; }
+    const Value& value(size_t i) const { return slots[i].value; }
+
+    void move(size_t to, size_t from) { slots[to] = slots[from]; }
+
+    const void* key_address(size_t i) const { return &slots[i]; }
+
+  private:
+    struct Slot {
+      KeyPart key;
+      Value value;
+    };
+    std::vector<Slot> slots;
+  };
+};
+
+struct SeparateArrays {
+  template <typename KeyPart, typename Value>
+  class Storage {
+  public:
+    void assign(size_t n, const KeyPart& empty) {
+      keys.assign(n, empty);
+      values.assign(n, Value());
+    }
+
+    size_t size() const { return keys.size(); }
+
+    KeyPart& key(size_t i) { return keys[i]; }
+    const KeyPart& key(size_t i) const { return keys[i]; }
+    Value& value(size_t i) { return values[i]; }
+    const Value& value(size_t i) const { return values[i]; }
+
+    void move(size_t to, size_t from) {
+      keys[to] = keys[from];
+      values[to] = values[from];
+    }
+
+    const void* key_address(size_t i) const { return &keys[i]; }
+
+  private:
+    std::vector<KeyPart> keys;
+    std::vector<Value> values;
+  };
+};
+
+/**
+ * Macro: FOR_EACH_LAYOUT(X, Hash, Capacity)
+ * ----------------------------------------------------------------------------
+ * Expands X(Hash, Capacity, Layout) once for every layout policy, for the
+ * explicit instantiations of the maps.
+ */
+#define FOR_EACH_LAYOUT(X, Hash, Capacity) \
+  X(Hash, Capacity, InlineSlots)           \
+  X(Hash, Capacity, SeparateArrays)
+
+#endif
@@ -0,0 +1,266 @@
+#include "MultipleChoiceHashTable.h"
+
+#include <algorithm>
+#include <climits>
+#include <new>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const int EMPTY = INT_MIN;
+static const size_t kCacheLine = 64;
+
+/* Returns a bitmask with bit i set if keys[i] == value, for the sixteen keys
+ * of a bucket.
+ */
+static inline unsigned match_key(const int* keys, int value) {
+#if defined(__SSE2__)
+  __m128i target = _mm_set1_epi32(value);
+  unsigned mask = 0;
+  for (int i = 0; i < 4; i++) {
+    __m128i group = _mm_load_si128(reinterpret_cast<const __m128i*>(keys) + i);
+    __m128i equal = _mm_cmpeq_epi32(group, target);
+    mask |= unsigned(_mm_movemask_ps(_mm_castsi128_ps(equal))) << (4 * i);
+  }
+  return mask;
+#else
+  unsigned mask = 0;
+  for (int i = 0; i < 16; i++) mask |= unsigned(keys[i] == value) << i;
+  return mask;
+#endif
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::BasicMultipleChoiceHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family)
+{
+  static_assert(kSlotsPerBucket == 16 && sizeof(Bucket) == kCacheLine, "match_key expects buckets of one cache line");
+  for (auto& hashFunction : this->hashFunctions) hashFunction = sampleHash<Hash>(family);
+  this->capacity = Capacity(numBuckets);
+
+  // std::vector can't be trusted with alignments beyond 16 bytes before C++17
+  void* memory = nullptr;
+  if (posix_memalign(&memory, kCacheLine, std::max<size_t>(this->capacity.size(), 1) * sizeof(Bucket)) != 0) {
+    throw std::bad_alloc();
+  }
+  this->buckets.reset(static_cast<Bucket*>(memory));
+  std::fill_n(&this->buckets[0].keys[0], this->capacity.size() * kSlotsPerBucket, EMPTY);
+
+  this->overflow_count = 0;
+  this->number_of_elements = 0;
+  this->contains_empty_key = false;
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::~BasicMultipleChoiceHashTable()
+{
+  // the buckets' unique_ptr frees them
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+void BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::insert(int data)
+{
+  if (data == EMPTY) {
+    this->contains_empty_key = true;
+    return;
+  }
+  this->insert_at(data, this->indices_for_data(data));
+}
+
+/**
+ * Looks for data in every candidate bucket, counting free slots on the way,
+ * and puts it into the emptiest bucket, the first of them on ties. Only if
+ * all of them are full does it go to the overflow area.
+ */
+template <typename Hash, size_t Choices, typename Capacity>
+void BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::insert_at(int data, const Indices& indices)
+{
+  size_t best = 0;
+  unsigned best_free = 0;
+  for (size_t choice = 0; choice < Choices; choice++) {
+    const int* keys = this->buckets[indices[choice]].keys;
+    if (match_key(keys, data)) return; // found data; don't insert duplicate
+    unsigned free = match_key(keys, EMPTY);
+    if (__builtin_popcount(free) > __builtin_popcount(best_free)) {
+      best = choice;
+      best_free = free;
+    }
+  }
+  if (this->in_overflow(data, indices)) return;
+
+  if (best_free) {
+    this->buckets[indices[best]].keys[__builtin_ctz(best_free)] = data;
+  } else {
+    this->add_overflow(data, indices);
+  }
+  this->number_of_elements++;
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+bool BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::contains(int data) const
+{
+  if (data == EMPTY) return this->contains_empty_key;
+  return this->contains_at(data, this->indices_for_data(data));
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+bool BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::contains_at(int data, const Indices& indices) const
+{
+  unsigned found = 0;
+  for (size_t choice = 0; choice < Choices; choice++) {
+    found |= match_key(this->buckets[indices[choice]].keys, data);
+  }
+  if (found) return true;
+  return this->in_overflow(data, indices);
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+void BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::contains_many(const int* keys, size_t n, bool* out) const
+{
+  size_t hashes[Choices][kBatchSize];
+  Indices indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    for (size_t choice = 0; choice < Choices; choice++) {
+      hashMany(this->hashFunctions[choice], keys + start, count, hashes[choice]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      for (size_t choice = 0; choice < Choices; choice++) {
+        indices[i][choice] = this->capacity.index(hashes[choice][i]);
+        prefetch(&this->buckets[indices[i][choice]]);
+      }
+    }
+    for (size_t i = 0; i < count; i++) {
+      int data = keys[start + i];
+      out[start + i] = data == EMPTY ? this->contains_empty_key : this->contains_at(data, indices[i]);
+    }
+  }
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+void BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::insert_many(const int* keys, size_t n)
+{
+  size_t hashes[Choices][kBatchSize];
+  Indices indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    for (size_t choice = 0; choice < Choices; choice++) {
+      hashMany(this->hashFunctions[choice], keys + start, count, hashes[choice]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      for (size_t choice = 0; choice < Choices; choice++) {
+        indices[i][choice] = this->capacity.index(hashes[choice][i]);
+        prefetch(&this->buckets[indices[i][choice]]);
+      }
+    }
+    for (size_t i = 0; i < count; i++) {
+      int data = keys[start + i];
+      if (data == EMPTY) {
+        this->contains_empty_key = true;
+      } else {
+        this->insert_at(data, indices[i]);
+      }
+    }
+  }
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+void BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::remove(int data)
+{
+  if (data == EMPTY) {
+    this->contains_empty_key = false;
+    return;
+  }
+  Indices indices = this->indices_for_data(data);
+  for (size_t index : indices) {
+    unsigned found = match_key(this->buckets[index].keys, data);
+    if (found) {
+      size_t slot = __builtin_ctz(found);
+      this->buckets[index].keys[slot] = EMPTY;
+      this->number_of_elements--;
+      this->refill(index, slot);
+      return;
+    }
+  }
+
+  if (this->in_overflow(data, indices)) {
+    this->drop_overflow(data, indices);
+    this->number_of_elements--;
+  }
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+bool BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::in_overflow(int data, const Indices& indices) const
+{
+  if (this->overflow_count == 0) return false;
+  auto listed = this->overflow.find(indices[0]);
+  return listed != this->overflow.end() &&
+         std::find(listed->second.begin(), listed->second.end(), data) != listed->second.end();
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+void BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::add_overflow(int data, const Indices& indices)
+{
+  for (size_t choice = 0; choice < Choices; choice++) {
+    // A bucket chosen twice lists the key once.
+    if (std::find(indices.begin(), indices.begin() + choice, indices[choice]) != indices.begin() + choice) continue;
+    this->overflow[indices[choice]].push_back(data);
+  }
+  this->overflow_count++;
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+void BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::drop_overflow(int data, const Indices& indices)
+{
+  for (size_t index : indices) {
+    auto listed = this->overflow.find(index);
+    if (listed == this->overflow.end()) continue;
+    auto& keys = listed->second;
+    auto key = std::find(keys.begin(), keys.end(), data);
+    if (key == keys.end()) continue; // a bucket chosen twice, already done
+    keys.erase(key);
+    if (keys.empty()) this->overflow.erase(listed);
+  }
+  this->overflow_count--;
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+void BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::refill(size_t index, size_t slot)
+{
+  if (this->overflow_count == 0) return;
+  auto listed = this->overflow.find(index);
+  if (listed == this->overflow.end()) return;
+  int key = listed->second.back();
+  this->drop_overflow(key, this->indices_for_data(key));
+  this->buckets[index].keys[slot] = key;
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+size_t BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::size() const
+{
+  return this->number_of_elements + (this->contains_empty_key ? 1 : 0);
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+size_t BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::overflow_size() const
+{
+  return this->overflow_count;
+}
+
+template <typename Hash, size_t Choices, typename Capacity>
+typename BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::Indices
+BasicMultipleChoiceHashTable<Hash, Choices, Capacity>::indices_for_data(int data) const
+{
+  Indices indices;
+  for (size_t choice = 0; choice < Choices; choice++) {
+    indices[choice] = this->capacity.index(this->hashFunctions[choice](data));
+  }
+  return indices;
+}
+
+#define INSTANTIATE(Hash, Capacity)                                  \
+  template class BasicMultipleChoiceHashTable<Hash, 2, Capacity>;   \
+  template class BasicMultipleChoiceHashTable<Hash, 3, Capacity>;   \
+  template class BasicMultipleChoiceHashTable<Hash, 4, Capacity>;
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
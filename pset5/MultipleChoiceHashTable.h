@@ -0,0 +1,150 @@
+#ifndef MultipleChoiceHashTable_Included
+#define MultipleChoiceHashTable_Included
+
+#include "Hashes.h"
+#include "Capacity.h"
+#include "Batch.h"
+
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * d-choice hashing with fixed-size buckets: every key has Choices candidate
+ * buckets, chosen by as many hash functions, and goes into whichever of them
+ * holds the fewest keys. Every bucket is an inline array of kSlotsPerBucket
+ * keys, exactly one aligned cache line, so a lookup touches Choices cache
+ * lines and never allocates, unlike SecondChoiceHashTable, whose buckets are
+ * vectors of their own.
+ *
+ * With n keys in n buckets, the fullest bucket holds ln ln n / ln d + O(1)
+ * keys with high probability (Azar, Broder, Karlin and Upfal), a handful for
+ * two choices and fewer for more; at an average load of m keys per bucket it
+ * holds about m more than that. Sixteen slots thus hold every key up to
+ * average loads of ten or so. The rare key whose candidate buckets are all
+ * full goes to a small overflow area, which removals drain back into the
+ * buckets. The overflow area lists every key in it under each of its
+ * candidate buckets, so a lookup searches only the few overflowed keys that
+ * share its first bucket, and a removal finds a key to move into the freed
+ * slot without rehashing the others.
+ *
+ * Empty slots hold a sentinel key. As in BucketizedCuckooHashTable, the
+ * sentinel itself can still be stored: whether it is in the table is tracked
+ * in a separate flag.
+ *
+ * Like the other tables it is templated on its hash function, and on a
+ * Capacity policy (see Capacity.h) that maps hashes onto buckets.
+ */
+template <typename Hash, size_t Choices = 2, typename Capacity = ModuloCapacity>
+class BasicMultipleChoiceHashTable {
+public:
+  static_assert(Choices >= 2, "d-choice hashing needs at least two choices");
+
+  /**
+   * Constructs a new d-choice table with the specified number of buckets,
+   * using Choices hash functions drawn from the indicated family of hash
+   * functions. The table never changes its number of buckets.
+   */
+  BasicMultipleChoiceHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+
+  /**
+   * Cleans up all memory allocated by this hash table.
+   */
+  ~BasicMultipleChoiceHashTable();
+
+  /**
+   * Inserts the specified element into this hash table. If the element already
+   * exists, this operation is a no-op.
+   */
+  void insert(int key);
+
+  /**
+   * Returns whether the specified key is contained in this hash table.
+   */
+  bool contains(int key) const;
+
+  /**
+   * Removes the specified element from this hash table. If the element is not
+   * present in the hash table, this operation is a no-op. The freed slot is
+   * given to a key from the overflow area that has its bucket as a choice,
+   * if there is one.
+   */
+  void remove(int key);
+
+  /**
+   * Batched lookup: sets out[i] to contains(keys[i]) for every i < n, after
+   * prefetching all candidate buckets of a whole batch of keys (see Batch.h).
+   */
+  void contains_many(const int* keys, size_t n, bool* out) const;
+
+  /**
+   * Inserts keys[0], ..., keys[n - 1], prefetching their candidate buckets a
+   * batch at a time.
+   */
+  void insert_many(const int* keys, size_t n);
+
+  /**
+   * The number of keys stored, and how many of them are in the overflow
+   * area.
+   */
+  size_t size() const;
+  size_t overflow_size() const;
+
+  static const size_t kSlotsPerBucket = 16;
+
+private:
+  struct alignas(64) Bucket {
+    int keys[kSlotsPerBucket];
+  };
+
+  /* Frees the buckets, which are allocated aligned to a cache line. */
+  struct FreeBuckets {
+    void operator()(Bucket* buckets) const { std::free(buckets); }
+  };
+
+  typedef std::array<size_t, Choices> Indices;
+
+  Indices indices_for_data(int data) const;
+
+  /* contains and insert, given the candidate buckets of data. */
+  bool contains_at(int data, const Indices& indices) const;
+  void insert_at(int data, const Indices& indices);
+
+  /* Whether data, with the given candidate buckets, is in the overflow area. */
+  bool in_overflow(int data, const Indices& indices) const;
+
+  /* Adds data to or drops it from the overflow area, under every one of its
+   * candidate buckets.
+   */
+  void add_overflow(int data, const Indices& indices);
+  void drop_overflow(int data, const Indices& indices);
+
+  /* Moves a key from the overflow area into the free slot of the given
+   * bucket, if one of them has that bucket as a choice.
+   */
+  void refill(size_t index, size_t slot);
+
+  std::array<Hash, Choices> hashFunctions;
+  std::unique_ptr<Bucket[], FreeBuckets> buckets;
+  std::unordered_map<size_t, std::vector<int>> overflow; // by candidate bucket
+  size_t overflow_count; // keys in the overflow area, each listed Choices times
+  size_t number_of_elements;
+  Capacity capacity;
+  bool contains_empty_key;
+
+  /* Fun with C++: these next two lines disable implicitly-generated copy
+   * functions that would otherwise cause weird errors if you tried to
+   * implicitly copy an object of this type. You don't need to touch these
+   * lines.
+   */
+  BasicMultipleChoiceHashTable(BasicMultipleChoiceHashTable const &) = delete;
+  void operator=(BasicMultipleChoiceHashTable const &) = delete;
+};
+
+/* The type-erased tables, usable with every hash family. */
+template <size_t Choices = 2>
+using MultipleChoiceHashTable = BasicMultipleChoiceHashTable<HashFunction, Choices>;
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef Results_Included
+#define Results_Included
+
+#include "Histogram.h"
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Machine-readable benchmark results. When run-tests is given --csv or
+ * --json and a file name, every ns / op figure the reports print is also
+ * written to that file as a record of
+ *
+ *    table        the section of the run, e.g. "Timing Linear Probing"
+ *    family       the hash family
+ *    load_factor  empty (CSV) or null (JSON) where there is none
+ *    operation    e.g. "Query" or "Insertion (batched)"
+ *    ns_per_op
+ *    p50, p99, p99_9, max
+ *                 nanoseconds, for reports that sample single operations
+ *    compiler     the compiler version
+ *    flags        the flags run-tests was built with
+ *
+ * compare-runs (Compare.cc) reads both formats back and flags regressions
+ * between runs.
+ */
+
+/* The flags the Makefile builds with, passed in as BUILD_FLAGS. */
+#ifndef BUILD_FLAGS
+#define BUILD_FLAGS "unknown"
+#endif
+
+#ifdef __VERSION__
+static const char* const kCompilerVersion = __VERSION__;
+#else
+static const char* const kCompilerVersion = "unknown";
+#endif
+
+static const char* const kResultFields[] = {
+  "table", "family", "load_factor", "operation", "ns_per_op",
+  "p50", "p99", "p99_9", "max", "compiler", "flags"
+};
+static const size_t kResultFieldCount = sizeof(kResultFields) / sizeof(kResultFields[0]);
+
+class ResultLog {
+public:
+  enum class Format { CSV, JSON };
+
+  /* The log the reports write to. It writes nothing until it is opened. */
+  static ResultLog& current() {
+    static ResultLog log;
+    return log;
+  }
+
+  ~ResultLog() {
+    close();
+  }
+
+  /**
+   * Starts writing records to path. Throws std::runtime_error if the file
+   * can't be opened.
+   */
+  void open(const std::string& path, Format format) {
+    close();
+    out.open(path, std::ios::trunc);
+    if (!out) throw std::runtime_error("Can't write results to " + path);
+    this->format = format;
+    this->records = 0;
+    if (format == Format::CSV) {
+      for (size_t i = 0; i < kResultFieldCount; i++) out << (i ? "," : "") << kResultFields[i];
+      out << "\n";
+    } else {
+      out << "[";
+    }
+  }
+
+  void close() {
+    if (!out.is_open()) return;
+    if (format == Format::JSON) out << (records ? "\n]\n" : "]\n");
+    out.close();
+  }
+
+  /* What the next records are about. A new section forgets the family, a new
+   * family the load factor, and every change forgets the variant: a label
+   * such as a capacity policy that is added to the operation's name.
+   */
+  void section(const std::string& name) {
+    table = name;
+    setFamily("");
+  }
+
+  void setFamily(const std::string& name) {
+    family = name;
+    setLoadFactor(std::numeric_limits<double>::quiet_NaN());
+  }
+
+  void setLoadFactor(double loadFactor) {
+    this->loadFactor = loadFactor;
+    variant.clear();
+  }
+
+  void setVariant(const std::string& name) {
+    variant = name;
+  }
+
+  void record(const std::string& operation, double nsPerOp, const LatencyHistogram* latencies = nullptr) {
+    if (!out.is_open()) return;
+    std::vector<std::string> values = {
+      table, family, number(loadFactor), variant.empty() ? operation : operation + " (" + variant + ")",
+      number(nsPerOp), "", "", "", "", kCompilerVersion, BUILD_FLAGS
+    };
+    if (latencies) {
+      values[5] = std::to_string(latencies->percentile(0.5));
+      values[6] = std::to_string(latencies->percentile(0.99));
+      values[7] = std::to_string(latencies->percentile(0.999));
+      values[8] = std::to_string(latencies->max());
+    }
+    // table, family, operation, compiler and flags are strings
+    static const bool quoted[] = {true, true, false, true, false, false, false, false, false, true, true};
+
+    if (format == Format::CSV) {
+      for (size_t i = 0; i < kResultFieldCount; i++) out << (i ? "," : "") << csvField(values[i]);
+      out << "\n";
+    } else {
+      out << (records ? ",\n  {" : "\n  {");
+      for (size_t i = 0; i < kResultFieldCount; i++) {
+        out << (i ? ", " : "") << "\"" << kResultFields[i] << "\": "
+            << (quoted[i] ? jsonString(values[i]) : values[i].empty() ? "null" : values[i]);
+      }
+      out << "}";
+    }
+    records++;
+    out.flush();
+  }
+
+private:
+  ResultLog() : format(Format::CSV), records(0), loadFactor(std::numeric_limits<double>::quiet_NaN()) {}
+
+  static std::string number(double value) {
+    if (std::isnan(value)) return "";
+    std::ostringstream text;
+    text.precision(6);
+    text << value;
+    return text.str();
+  }
+
+  static std::string csvField(const std::string& value) {
+    if (value.find_first_of(",\"\n") == std::string::npos) return value;
+    std::string result = "\"";
+    for (char c : value) result += c == '"' ? std::string("\"\"") : std::string(1, c);
+    return result + "\"";
+  }
+
+  static std::string jsonString(const std::string& value) {
+    std::string result = "\"";
+    for (char c : value) {
+      if (c == '"' || c == '\\') result += '\\';
+      if (c == '\n') {
+        result += "\\n";
+        continue;
+      }
+      result += c;
+    }
+    return result + "\"";
+  }
+
+  std::ofstream out;
+  Format format;
+  size_t records;
+  std::string table;
+  std::string family;
+  double loadFactor;
+  std::string variant;
+
+  ResultLog(ResultLog const &) = delete;
+  void operator=(ResultLog const &) = delete;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdexcept>
+#include <utility>
+#include "RobinHoodHashMap.h"
+
+static const uint32_t EMPTY = 0;
+static const size_t npos = size_t(-1);
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::BasicRobinHoodHashMap(size_t numBuckets, std::shared_ptr<HashFamily> family)
+{
+  this->hashFunction = sampleHash<Hash>(family);
+  this->capacity = Capacity(numBuckets);
+  if (this->capacity.size() >= UINT32_MAX) {
+    throw std::length_error("RobinHoodHashMap: too many buckets for 32-bit probe distances");
+  }
+  this->buckets.assign(this->capacity.size(), Bucket{0, EMPTY});
+  this->number_of_elements = 0;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::~BasicRobinHoodHashMap()
+{
+  // the storage's vectors clean up after themselves
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+bool BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::insert(int data, const Value& value)
+{
+  return place(data, value, false);
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+void BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::upsert(int data, const Value& value)
+{
+  place(data, value, true);
+}
+
+/**
+ * Works like RobinHoodHashTable::insert, carrying a value along with the key
+ * being placed: whenever a richer key is evicted, its value comes with it.
+ */
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+bool BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::place(int data, const Value& value, bool replace)
+{
+  if (this->number_of_elements == this->buckets.size()) { // no hole to end the scan
+    size_t index = this->find_bucket(data);
+    if (index == npos) throw std::length_error("RobinHoodHashMap: every bucket holds a key");
+    if (replace) this->buckets.value(index) = value;
+    return false;
+  }
+  size_t index = this->index_for_data(data);
+  Bucket carried = Bucket{data, 1};
+  Value carried_value = value;
+  bool displaced = false; // set once we carry an evicted element instead of data
+
+  while (this->buckets.key(index).probe != EMPTY) {
+    Bucket& bucket = this->buckets.key(index);
+    if (!displaced && bucket.key == data) { // found data; don't insert duplicate
+      if (replace) this->buckets.value(index) = value;
+      return false;
+    }
+    if (bucket.probe < carried.probe) { // bucket is richer; take it, carry its element on
+      std::swap(bucket, carried);
+      std::swap(this->buckets.value(index), carried_value);
+      displaced = true;
+    }
+    index = this->capacity.next(index); // continue scanning
+    carried.probe++; // at most the number of buckets, which fits
+  }
+  this->buckets.key(index) = carried;
+  this->buckets.value(index) = carried_value;
+  this->number_of_elements++;
+  return true;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+size_t BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::find_bucket(int data) const
+{
+  size_t index = this->index_for_data(data);
+  for (size_t probe = 1; probe <= this->buckets.size(); probe++) {
+    // found a hole, or an element closer to home than data would be
+    if (this->buckets.key(index).probe < probe) return npos;
+    if (this->buckets.key(index).key == data) return index;
+    index = this->capacity.next(index);
+  }
+  return npos;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+Value* BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::find(int data)
+{
+  size_t index = this->find_bucket(data);
+  return index == npos ? nullptr : &this->buckets.value(index);
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+const Value* BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::find(int data) const
+{
+  size_t index = this->find_bucket(data);
+  return index == npos ? nullptr : &this->buckets.value(index);
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+void BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::remove(int data)
+{
+  size_t index = this->find_bucket(data);
+  if (index == npos) return;
+  this->number_of_elements--;
+
+  // shift everything after it left by one, until we find a hole or an element
+  // in its home bucket
+  size_t next_index = this->capacity.next(index);
+  while (this->buckets.key(next_index).probe > 1) {
+    this->buckets.move(index, next_index);
+    this->buckets.key(index).probe--;
+    index = next_index;
+    next_index = this->capacity.next(index);
+  }
+
+  this->buckets.key(index) = Bucket{0, EMPTY};
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+size_t BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::size() const
+{
+  return this->number_of_elements;
+}
+
+template <typename Hash, typename Capacity, typename Layout, typename Value>
+size_t BasicRobinHoodHashMap<Hash, Capacity, Layout, Value>::index_for_data(int data) const
+{
+  size_t hash_value = this->hashFunction(data);
+  size_t index = this->capacity.index(hash_value);
+  return index;
+}
+
+#define INSTANTIATE_LAYOUT(Hash, Capacity, Layout)                         \
+  template class BasicRobinHoodHashMap<Hash, Capacity, Layout, int>;      \
+  template class BasicRobinHoodHashMap<Hash, Capacity, Layout, uint64_t>;
+#define INSTANTIATE(Hash, Capacity) FOR_EACH_LAYOUT(INSTANTIATE_LAYOUT, Hash, Capacity)
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
@@ -0,0 +1,104 @@
+#ifndef RobinHoodHashMap_Included
+#define RobinHoodHashMap_Included
+
+#include "Hashes.h"
+#include "Capacity.h"
+#include "MapLayout.h"
+
+#include <cstdint>
+
+/**
+ * A map from int keys to values of type Value, using Robin Hood hashing. It
+ * is RobinHoodHashTable with a value next to every key: each bucket's key
+ * part holds the key and its distance from home plus one, zero marking an
+ * empty bucket, so every int can be stored. Insertions displace richer keys
+ * along with their values, and removals shift backwards.
+ *
+ * The Layout policy (see MapLayout.h) picks whether values sit inline next to
+ * their keys (InlineSlots) or in an array of their own (SeparateArrays).
+ * Value should be small and cheap to copy, since values move along with
+ * their keys.
+ */
+template <typename Hash, typename Capacity = ModuloCapacity, typename Layout = InlineSlots, typename Value = int>
+class BasicRobinHoodHashMap {
+public:
+  typedef Value value_type;
+
+  /**
+   * Constructs a new Robin Hood map with the specified number of buckets,
+   * using hash functions drawn from the indicated family of hash functions.
+   * The map never changes its number of buckets.
+   */
+  BasicRobinHoodHashMap(size_t numBuckets, std::shared_ptr<HashFamily> family);
+
+  /**
+   * Cleans up all memory allocated by this map.
+   */
+  ~BasicRobinHoodHashMap();
+
+  /**
+   * Maps key to value, unless key is already present, in which case its value
+   * is left as it is. Returns whether key was inserted.
+   */
+  bool insert(int key, const Value& value);
+
+  /**
+   * Maps key to value, replacing any value it had.
+   *
+   * Both throw std::length_error when key is new and every bucket already
+   * holds a key.
+   */
+  void upsert(int key, const Value& value);
+
+  /**
+   * Returns a pointer to the value of key, or nullptr if key isn't present.
+   * The pointer stays valid until the next insert, upsert or remove.
+   */
+  Value* find(int key);
+  const Value* find(int key) const;
+
+  /**
+   * Removes key and its value from this map. If key is not present, this
+   * operation is a no-op.
+   */
+  void remove(int key);
+
+  /**
+   * Returns the number of keys in this map.
+   */
+  size_t size() const;
+
+private:
+  /* The key part of a bucket, as in RobinHoodHashTable. */
+  struct Bucket {
+    int key;
+    uint32_t probe;
+  };
+
+  /* Returns the bucket holding key, or npos if there is none. */
+  size_t find_bucket(int key) const;
+
+  /* insert and upsert; 'replace' says whether to overwrite a present key. */
+  bool place(int key, const Value& value, bool replace);
+
+  size_t index_for_data(int data) const;
+
+  typename Layout::template Storage<Bucket, Value> buckets;
+  size_t number_of_elements;
+  Capacity capacity;
+  Hash hashFunction;
+
+  /* Fun with C++: these next two lines disable implicitly-generated copy
+   * functions that would otherwise cause weird errors if you tried to
+   * implicitly copy an object of this type. You don't need to touch these
+   * lines.
+   */
+  BasicRobinHoodHashMap(BasicRobinHoodHashMap const &) = delete;
+  void operator=(BasicRobinHoodHashMap const &) = delete;
+};
+
+/* The type-erased maps, usable with every hash family. */
+template <typename Layout, typename Value = int>
+using RobinHoodHashMap = BasicRobinHoodHashMap<HashFunction, ModuloCapacity, Layout, Value>;
+
+#endif
@@ -1,130 +1,252 @@
+#include <algorithm>
+#include <stdexcept>
+#include <typeinfo>
+#include <utility>
 #include "RobinHoodHashTable.h"
 
-static int EMPTY = -1;
+static const uint32_t EMPTY = 0;
 
-RobinHoodHashTable::RobinHoodHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family) {
-  this->hashFunction = family->get();
-  this->buckets = std::vector<std::pair<int, size_t>>(numBuckets, std::pair<int, size_t>(EMPTY, 0));
+template <typename Hash, typename Capacity>
+BasicRobinHoodHashTable<Hash, Capacity>::BasicRobinHoodHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family) {
+  this->hashFunction = sampleHash<Hash>(family);
+  this->capacity = Capacity(numBuckets);
+  if (this->capacity.size() >= UINT32_MAX) {
+    throw std::length_error("RobinHoodHashTable: too many buckets for 32-bit probe distances");
+  }
+  this->buckets = BucketArray<Bucket>(this->capacity.size(), Bucket{0, EMPTY});
+  this->max_probe = EMPTY;
+  this->number_of_elements = 0;
 }
 
-RobinHoodHashTable::~RobinHoodHashTable() {
+template <typename Hash, typename Capacity>
+BasicRobinHoodHashTable<Hash, Capacity>::~BasicRobinHoodHashTable() {
   // TODO: Implement this
 }
 
-void RobinHoodHashTable::insert(int data) {
-  size_t index = this->index_for_data(data);
-  size_t home = index;
-  int data_at_index;
-  size_t home_at_index;
-  while(this->buckets[index].first != EMPTY) {
-    std::tie(data_at_index, home_at_index) = this->buckets[index];
-    if (data_at_index == data) return; // found data; don't insert duplicate
-    size_t data_at_index_distance = index_distance(index, home_at_index);
-    size_t data_distance          = index_distance(index, home);
-    if (data_at_index_distance < data_distance) {
-      this->buckets[index] = std::pair<int, size_t>(data, home);
-      insert(data_at_index);
-      return;
+template <typename Hash, typename Capacity>
+void BasicRobinHoodHashTable<Hash, Capacity>::insert(int data) {
+  insert_at(data, this->index_for_data(data));
+}
+
+template <typename Hash, typename Capacity>
+void BasicRobinHoodHashTable<Hash, Capacity>::insert_at(int data, size_t index) {
+  if (this->number_of_elements == this->buckets.size()) { // no hole to end the scan
+    if (contains_at(data, index)) return;
+    throw std::length_error("RobinHoodHashTable: every bucket holds a key");
+  }
+  Bucket carried = Bucket{data, 1};
+  bool displaced = false; // set once we carry an evicted element instead of data
+
+  while (this->buckets[index].probe != EMPTY) {
+    Bucket& bucket = this->buckets[index];
+    if (!displaced && bucket.key == data) return; // found data; don't insert duplicate
+    if (bucket.probe < carried.probe) { // bucket is richer; take it, carry its element on
+      count_probe(carried.probe);
+      std::swap(bucket, carried);
+      uncount_probe(carried.probe);
+      displaced = true;
     }
-    index = next_index(index); // continue scanning
+    index = this->next_index(index); // continue scanning
+    carried.probe++; // at most the number of buckets, which fits
   }
-  this->buckets[index] = std::pair<int, size_t>(data, home);
+  this->buckets[index] = carried;
+  count_probe(carried.probe);
+  this->number_of_elements++;
 }
 
-bool RobinHoodHashTable::contains(int data) const {
-  size_t index = this->index_for_data(data);
-  size_t home = index;
-  int data_at_index;
-  size_t home_at_index;
-  while(this->buckets[index].first != EMPTY) {
-    std::tie(data_at_index, home_at_index) = this->buckets[index];
-    if (data_at_index == data) return true;
-    size_t data_at_index_distance = index_distance(index, home_at_index);
-    size_t data_distance          = index_distance(index, home);
-    if (data_at_index_distance < data_distance) return false;
+template <typename Hash, typename Capacity>
+bool BasicRobinHoodHashTable<Hash, Capacity>::contains(int data) const {
+  return contains_at(data, this->index_for_data(data));
+}
+
+template <typename Hash, typename Capacity>
+bool BasicRobinHoodHashTable<Hash, Capacity>::contains_at(int data, size_t index) const {
+  for (size_t probe = 1; probe <= this->max_probe; probe++) {
+    // found a hole, or an element closer to home than data would be
+    if (this->buckets[index].probe < probe) return false;
+    if (this->buckets[index].key == data) return true;
     index = this->next_index(index);
   }
   return false;
 }
 
-void RobinHoodHashTable::remove(int data) {
+template <typename Hash, typename Capacity>
+void BasicRobinHoodHashTable<Hash, Capacity>::remove(int data) {
   size_t index = this->index_for_data(data);
-  size_t home = index;
-  int data_at_index;
-  size_t home_at_index;
 
   // search for element to remove
-  while(true) {
-    std::tie(data_at_index, home_at_index) = this->buckets[index];
+  for (size_t probe = 1; ; probe++) {
+    // found hole or too far? give up search
+    if (probe > this->max_probe || this->buckets[index].probe < probe) return;
 
     // found?
-    if (data_at_index == data) break;
-
-    // found hole? give up search
-    if (data_at_index == EMPTY) return;
-
-    // too far? give up search
-    size_t data_at_index_distance = index_distance(index, home_at_index);
-    size_t data_distance          = index_distance(index, home);
-    if (data_at_index_distance < data_distance) return;
+    if (this->buckets[index].key == data) break;
 
     index = this->next_index(index);
   }
-  // found element
-  size_t shift_start = index;
+  uncount_probe(this->buckets[index].probe);
+  this->number_of_elements--;
 
-  // search for end of elements to shift
-  index = this->next_index(index);
-  while(true) {
-    std::tie(data_at_index, home_at_index) = this->buckets[index];
+  // shift everything after it left by one, until we find a hole or an element
+  // in its home bucket
+  size_t next_index = this->next_index(index);
+  while (this->buckets[next_index].probe > 1) {
+    this->buckets[index] = this->buckets[next_index];
+    uncount_probe(this->buckets[index].probe);
+    this->buckets[index].probe--;
+    count_probe(this->buckets[index].probe);
+    index = next_index;
+    next_index = this->next_index(index);
+  }
 
-    // found hole? end here
-    if (data_at_index == EMPTY) break;
+  this->buckets[index] = Bucket{0, EMPTY};
+}
 
-    // element in its place
-    if (!index_distance(index, home_at_index)) break;
+template <typename Hash, typename Capacity>
+void BasicRobinHoodHashTable<Hash, Capacity>::contains_many(const int* keys, size_t n, bool* out) const {
+  size_t hashes[kBatchSize];
+  size_t indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction, keys + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = this->capacity.index(hashes[i]);
+      prefetch(&this->buckets[indices[i]]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      out[start + i] = contains_at(keys[start + i], indices[i]);
+    }
+  }
+}
 
-    index = this->next_index(index);
+template <typename Hash, typename Capacity>
+void BasicRobinHoodHashTable<Hash, Capacity>::insert_many(const int* keys, size_t n) {
+  size_t hashes[kBatchSize];
+  size_t indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction, keys + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = this->capacity.index(hashes[i]);
+      prefetch(&this->buckets[indices[i]]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      insert_at(keys[start + i], indices[i]);
+    }
   }
+}
 
-  // shift everything left by one
-  size_t shift_end = previous_index(index);
-  size_t distance = index_distance(shift_end, shift_start);
-  index = shift_start;
-  for (size_t count = 0; count < distance; count++) {
-    size_t next_index = this->next_index(index);
-    this->buckets[index] = this->buckets[next_index];
-    index = next_index;
+/**
+ * The counters are the element count followed by the probe length
+ * histogram, whose length is max_probe, so that lookups in a loaded table
+ * stop as early as they did in the saved one.
+ */
+template <typename Hash, typename Capacity>
+void BasicRobinHoodHashTable<Hash, Capacity>::save(const std::string& path) const {
+  if (!HashSerialization<Hash>::kSerializable) {
+    throw std::logic_error("Only tables with a concrete hash function can be saved.");
+  }
+  SnapshotContents contents;
+  contents.type = typeid(BasicRobinHoodHashTable).name();
+  contents.hash = &this->hashFunction;
+  contents.hash_bytes = sizeof(Hash);
+  contents.counters.push_back(this->number_of_elements);
+  contents.counters.insert(contents.counters.end(), this->probe_histogram.begin(),
+                           this->probe_histogram.begin() + this->max_probe);
+  contents.buckets = this->buckets.data();
+  contents.bucket_count = this->buckets.size();
+  contents.bucket_bytes = sizeof(Bucket);
+  writeSnapshot(path, contents);
+}
+
+template <typename Hash, typename Capacity>
+std::unique_ptr<BasicRobinHoodHashTable<Hash, Capacity>>
+BasicRobinHoodHashTable<Hash, Capacity>::load(const std::string& path, bool verify) {
+  if (!HashSerialization<Hash>::kSerializable) {
+    throw std::logic_error("Only tables with a concrete hash function can be loaded.");
+  }
+  LoadedSnapshot snapshot = readSnapshot(path, typeid(BasicRobinHoodHashTable).name(), sizeof(Hash),
+                                         sizeof(Bucket), verify);
+  if (snapshot.counters.empty() || snapshot.counters.size() - 1 > UINT32_MAX) {
+    throw std::runtime_error("Snapshot " + path + " has the wrong counters");
   }
 
-  this->buckets[shift_end] = std::pair<int, size_t>(EMPTY, 0);
+  std::unique_ptr<BasicRobinHoodHashTable> table(new BasicRobinHoodHashTable());
+  table->hashFunction = readHash<Hash>(snapshot.hash);
+  table->capacity = Capacity(snapshot.bucket_count);
+  table->buckets = BucketArray<Bucket>(snapshot.file, static_cast<Bucket*>(snapshot.buckets), snapshot.bucket_count);
+  table->number_of_elements = snapshot.counters[0];
+  table->probe_histogram.assign(snapshot.counters.begin() + 1, snapshot.counters.end());
+  table->max_probe = uint32_t(table->probe_histogram.size());
+  return table;
+}
+
+template <typename Hash, typename Capacity>
+typename BasicRobinHoodHashTable<Hash, Capacity>::Stats BasicRobinHoodHashTable<Hash, Capacity>::stats() const {
+  Stats result;
+  result.max_probe_length = this->max_probe == EMPTY ? 0 : this->max_probe - 1;
+  result.histogram = this->probe_histogram;
+  result.histogram.resize(this->max_probe);
+  return result;
+}
+
+template <typename Hash, typename Capacity>
+size_t BasicRobinHoodHashTable<Hash, Capacity>::size() const {
+  return this->number_of_elements;
+}
 
+template <typename Hash, typename Capacity>
+size_t BasicRobinHoodHashTable<Hash, Capacity>::slot_count() const {
+  return this->buckets.size();
+}
+
+template <typename Hash, typename Capacity>
+bool BasicRobinHoodHashTable<Hash, Capacity>::key_at(size_t slot, int& key) const {
+  key = this->buckets[slot].key;
+  return this->buckets[slot].probe != EMPTY;
+}
+
+template <typename Hash, typename Capacity>
+size_t BasicRobinHoodHashTable<Hash, Capacity>::migration_anchor() const {
+  for (size_t index = 0; index < this->buckets.size(); index++) {
+    if (this->buckets[index].probe == EMPTY) return index;
+  }
+  return 0; // a full table; removals have nowhere to shift keys past
 }
 
 /* Helper */
 
-inline size_t RobinHoodHashTable::previous_index(size_t index) const
+template <typename Hash, typename Capacity>
+inline void BasicRobinHoodHashTable<Hash, Capacity>::count_probe(uint32_t probe)
 {
-  if (index == 0) {
-    return this->buckets.size() - 1;
-  } else {
-    return index - 1;
+  if (probe > this->probe_histogram.size()) this->probe_histogram.resize(probe);
+  this->probe_histogram[probe - 1]++;
+  if (probe > this->max_probe) this->max_probe = probe;
+}
+
+template <typename Hash, typename Capacity>
+inline void BasicRobinHoodHashTable<Hash, Capacity>::uncount_probe(uint32_t probe)
+{
+  this->probe_histogram[probe - 1]--;
+  while (this->max_probe != EMPTY && this->probe_histogram[this->max_probe - 1] == 0) {
+    this->max_probe--;
   }
 }
 
-inline size_t RobinHoodHashTable::next_index(size_t index) const
+template <typename Hash, typename Capacity>
+inline size_t BasicRobinHoodHashTable<Hash, Capacity>::next_index(size_t index) const
 {
-  return ++index % this->buckets.size();
+  return this->capacity.next(index);
 }
 
-inline size_t RobinHoodHashTable::index_for_data(int data) const
+template <typename Hash, typename Capacity>
+inline size_t BasicRobinHoodHashTable<Hash, Capacity>::index_for_data(int data) const
 {
   size_t hash_value = this->hashFunction(data);
-  size_t index = hash_value % this->buckets.size();
+  size_t index = this->capacity.index(hash_value);
   return index;
 }
 
-size_t RobinHoodHashTable::index_distance(size_t index1, size_t index2) const
-{
-  return (index1 - index2) % this->buckets.size();
-}
+#define INSTANTIATE(Hash, Capacity) template class BasicRobinHoodHashTable<Hash, Capacity>;
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
@@ -2,10 +2,28 @@
 #define RobinHoodHashTable_Included
 
 #include "Hashes.h"
+#include "Capacity.h"
+#include "Batch.h"
+#include "Snapshot.h"
 
+#include <memory>
+#include <string>
 #include <vector>
+#include <cstdint>
 
-class RobinHoodHashTable {
+/**
+ * The table is templated on the type of its hash function. With Hash =
+ * HashFunction it accepts any HashFamily; with one of the concrete hashers
+ * from Hashes.h (e.g. TabulationHash) it must be given the matching family,
+ * and the hash is inlined into every probe.
+ *
+ * The Capacity policy (see Capacity.h) decides how hashes are mapped onto
+ * buckets. The default, ModuloCapacity, keeps the requested bucket count;
+ * PowerOfTwoCapacity and FastRangeCapacity trade exactness or hash quality
+ * requirements for cheaper index arithmetic.
+ */
+template <typename Hash, typename Capacity = ModuloCapacity>
+class BasicRobinHoodHashTable {
 public:
   /**
    * Constructs a new Robing Hood table with the specified number of buckets,
@@ -15,27 +33,36 @@ public:
    * table has initially be created.
    *
    * You can choose a hash function out of the family of hash functions by
-   * declaring a variable of type HashFunction and assigning it the value
-   * family->get(). For example:
+   * declaring a variable of type Hash and assigning it the value
+   * sampleHash<Hash>(family). For example:
    *
-   *    HashFunction h;
-   *    h = family->get();
+   *    Hash h;
+   *    h = sampleHash<Hash>(family);
    */
-  RobinHoodHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+  BasicRobinHoodHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
   
   /**
    * Cleans up all memory allocated by this hash table.
    */
-  ~RobinHoodHashTable();
+  ~BasicRobinHoodHashTable();
   
   /**
    * Inserts the specified element into this hash table. If the element already
-   * exists, this operation is a no-op.
+   * exists, this operation is a no-op. Throws std::length_error if every
+   * bucket already holds a key.
+   *
+   * Displacement is iterative: whenever the element being placed is farther
+   * from home than the one in the current bucket, the two are swapped and
+   * the scan continues with the evicted element, whose probe distance is
+   * already known, so no key is ever hashed twice.
    */
   void insert(int key);
   
   /**
    * Returns whether the specified key is contained in this hash tasble.
+   *
+   * No key is farther from home than the current maximum probe length, so the
+   * scan never goes past it, in addition to the usual Robin Hood early exit.
    */
   bool contains(int key) const;
   
@@ -50,14 +77,97 @@ public:
    */
   void remove(int key);
 
+  /**
+   * Batched lookup: sets out[i] to contains(keys[i]) for every i < n, after
+   * prefetching the home buckets of a whole batch of keys (see Batch.h).
+   */
+  void contains_many(const int* keys, size_t n, bool* out) const;
+
+  /**
+   * Inserts keys[0], ..., keys[n - 1], prefetching home buckets a batch at a
+   * time.
+   */
+  void insert_many(const int* keys, size_t n);
+
+  /**
+   * Snapshots (see Snapshot.h). save() writes this table's buckets, counters
+   * and hash function to path; load() maps such a file back in as a new
+   * table without reinserting anything. With verify set, load() checks the
+   * file's checksum first, at the cost of reading all of it.
+   *
+   * Only tables with a concrete hasher (e.g. TabulationHash) can be saved or
+   * loaded; for the type-erased HashFunction both throw std::logic_error.
+   * Other failures throw std::runtime_error.
+   */
+  void save(const std::string& path) const;
+  static std::unique_ptr<BasicRobinHoodHashTable> load(const std::string& path, bool verify = true);
+
+  /**
+   * Probe length statistics: how far from home the farthest element is, and
+   * histogram[d], the number of elements exactly d buckets from home.
+   */
+  struct Stats {
+    size_t max_probe_length;
+    std::vector<size_t> histogram;
+  };
+
+  /**
+   * Returns the current probe length statistics. Both values are maintained
+   * on every insert and remove, so this is cheap to call.
+   */
+  Stats stats() const;
+
+  /**
+   * Access for GrowableHashTable, which drains a full table into a larger
+   * one a few buckets at a time: size() is the number of keys stored, and
+   * key_at() says whether bucket 'slot' holds a key, and which.
+   *
+   * Backward-shift deletion never moves a key past an empty bucket, so
+   * migration_anchor() returns one for the migration to start from.
+   */
+  size_t size() const;
+  size_t slot_count() const;
+  bool key_at(size_t slot, int& key) const;
+  size_t migration_anchor() const;
+
+  /* The load factor above which GrowableHashTable grows the table. */
+  static constexpr double kMaxLoadFactor = 0.9;
+
   inline size_t index_for_data(int data) const;
-  inline size_t previous_index(size_t index) const;
   inline size_t next_index(size_t index) const;
-  inline size_t index_distance(size_t index1, size_t index2) const;
   
 private:
-  std::vector<std::pair<int, size_t>> buckets;
-  HashFunction hashFunction;
+  /* An empty shell for load() to fill in. */
+  BasicRobinHoodHashTable() = default;
+
+  /* contains and insert, given the home bucket of data. */
+  bool contains_at(int data, size_t index) const;
+  void insert_at(int data, size_t index);
+
+  /* Instead of its home index, each bucket stores how far its key is from
+   * home, plus one, so that zero can mark an empty bucket and every int can
+   * be stored as a key. That keeps a bucket at 8 bytes. The distance takes
+   * 32 bits, which fit in the same 8 bytes, so it can't overflow in any
+   * table with fewer than 2^32 - 1 buckets; the constructor rejects larger
+   * ones.
+   */
+  struct Bucket {
+    int key;
+    uint32_t probe;
+  };
+
+  /* Bookkeeping for a bucket gaining or losing an element that is probe - 1
+   * buckets from home.
+   */
+  void count_probe(uint32_t probe);
+  void uncount_probe(uint32_t probe);
+
+  BucketArray<Bucket> buckets;
+  std::vector<size_t> probe_histogram;
+  uint32_t max_probe;
+  size_t number_of_elements;
+  Capacity capacity;
+  Hash hashFunction;
   
   
   /* Fun with C++: these next two lines disable implicitly-generated copy
@@ -65,8 +175,11 @@ private:
    * implicitly copy an object of this type. You don't need to touch these
    * lines.
    */
-  RobinHoodHashTable(RobinHoodHashTable const &) = delete;
-  void operator=(RobinHoodHashTable const &) = delete;
+  BasicRobinHoodHashTable(BasicRobinHoodHashTable const &) = delete;
+  void operator=(BasicRobinHoodHashTable const &) = delete;
 };
 
+/* The type-erased table, usable with every hash family. */
+using RobinHoodHashTable = BasicRobinHoodHashTable<HashFunction>;
+
 #endif
@@ -1,16 +1,19 @@
 #include "SecondChoiceHashTable.h"
 
-SecondChoiceHashTable::SecondChoiceHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family) {
-  this->hashFunction1 = family->get();
-  this->hashFunction2 = family->get();
+template <typename Hash>
+BasicSecondChoiceHashTable<Hash>::BasicSecondChoiceHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family) {
+  this->hashFunction1 = sampleHash<Hash>(family);
+  this->hashFunction2 = sampleHash<Hash>(family);
   this->buckets = std::vector<std::vector<int>>(numBuckets, std::vector<int>(0));
 }
 
-SecondChoiceHashTable::~SecondChoiceHashTable() {
+template <typename Hash>
+BasicSecondChoiceHashTable<Hash>::~BasicSecondChoiceHashTable() {
   // TODO: Implement this
 }
 
-void SecondChoiceHashTable::insert(int data) {
+template <typename Hash>
+void BasicSecondChoiceHashTable<Hash>::insert(int data) {
   auto indices = this->indices_for_data(data);
   size_t index1 = indices.first;
   size_t index2 = indices.second;
@@ -34,25 +37,59 @@ void SecondChoiceHashTable::insert(int data) {
   }
 }
 
-bool SecondChoiceHashTable::contains(int data) const {
-  auto indices = this->indices_for_data(data);
-  size_t index1 = indices.first;
-  size_t index2 = indices.second;
-
-  auto bucket1 = this->buckets.at(index1);
-  auto iterator1 = std::find(bucket1.begin(), bucket1.end(), data);
+template <typename Hash>
+bool BasicSecondChoiceHashTable<Hash>::contains(int data) const {
+  return contains_at(data, this->indices_for_data(data));
+}
 
-  auto bucket2 = this->buckets.at(index2);
-  auto iterator2 = std::find(bucket2.begin(), bucket2.end(), data);
+template <typename Hash>
+bool BasicSecondChoiceHashTable<Hash>::contains_at(int data, std::pair<size_t, size_t> indices) const {
+  const auto& bucket1 = this->buckets[indices.first];
+  const auto& bucket2 = this->buckets[indices.second];
+  return std::find(bucket1.begin(), bucket1.end(), data) != bucket1.end() ||
+         std::find(bucket2.begin(), bucket2.end(), data) != bucket2.end();
+}
 
-  bool bucket1_contains = iterator1 != bucket1.end();
-  bool bucket2_contains = iterator2 != bucket2.end();
-  bool contains_data = bucket1_contains || bucket2_contains;
+template <typename Hash>
+void BasicSecondChoiceHashTable<Hash>::contains_many(const int* keys, size_t n, bool* out) const {
+  size_t hashes1[kBatchSize];
+  size_t hashes2[kBatchSize];
+  std::pair<size_t, size_t> indices[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction1, keys + start, count, hashes1);
+    hashMany(this->hashFunction2, keys + start, count, hashes2);
+    for (size_t i = 0; i < count; i++) {
+      indices[i] = std::make_pair(hashes1[i] % this->buckets.size(), hashes2[i] % this->buckets.size());
+      prefetch(&this->buckets[indices[i].first]);
+      prefetch(&this->buckets[indices[i].second]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      out[start + i] = contains_at(keys[start + i], indices[i]);
+    }
+  }
+}
 
-  return contains_data;
+template <typename Hash>
+void BasicSecondChoiceHashTable<Hash>::insert_many(const int* keys, size_t n) {
+  size_t hashes1[kBatchSize];
+  size_t hashes2[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction1, keys + start, count, hashes1);
+    hashMany(this->hashFunction2, keys + start, count, hashes2);
+    for (size_t i = 0; i < count; i++) {
+      prefetch(&this->buckets[hashes1[i] % this->buckets.size()]);
+      prefetch(&this->buckets[hashes2[i] % this->buckets.size()]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      insert(keys[start + i]);
+    }
+  }
 }
 
-void SecondChoiceHashTable::remove(int data) {
+template <typename Hash>
+void BasicSecondChoiceHashTable<Hash>::remove(int data) {
   auto indices = this->indices_for_data(data);
   size_t index1 = indices.first;
   size_t index2 = indices.second;
@@ -74,10 +111,14 @@ void SecondChoiceHashTable::remove(int data) {
   }
 }
 
-std::pair<size_t, size_t> SecondChoiceHashTable::indices_for_data(int data) const {
+template <typename Hash>
+std::pair<size_t, size_t> BasicSecondChoiceHashTable<Hash>::indices_for_data(int data) const {
   size_t hash_value1 = this->hashFunction1(data);
   size_t hash_value2 = this->hashFunction2(data);
   size_t index1 = hash_value1 % this->buckets.size();
   size_t index2 = hash_value2 % this->buckets.size();
   return std::pair<size_t, size_t>(index1, index2);
-}
\ No newline at end of file
+}
+
+#define INSTANTIATE(Hash) template class BasicSecondChoiceHashTable<Hash>;
+FOR_EACH_HASH(INSTANTIATE)
@@ -2,11 +2,19 @@
 #define SecondChoiceHashTable_Included
 
 #include "Hashes.h"
+#include "Batch.h"
 #include <vector>
 #include <forward_list>
 #include <algorithm>
 
-class SecondChoiceHashTable {
+/**
+ * The table is templated on the type of its hash function. With Hash =
+ * HashFunction it accepts any HashFamily; with one of the concrete hashers
+ * from Hashes.h (e.g. TabulationHash) it must be given the matching family,
+ * and the hash is inlined into every probe.
+ */
+template <typename Hash>
+class BasicSecondChoiceHashTable {
 public:
   /**
    * Constructs a new second-choice table with the specified number of buckets,
@@ -16,18 +24,18 @@ public:
    * table has initially be created.
    *
    * You can choose a hash function out of the family of hash functions by
-   * declaring a variable of type HashFunction and assigning it the value
-   * family->get(). For example:
+   * declaring a variable of type Hash and assigning it the value
+   * sampleHash<Hash>(family). For example:
    *
-   *    HashFunction h;
-   *    h = family->get();
+   *    Hash h;
+   *    h = sampleHash<Hash>(family);
    */
-  SecondChoiceHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
+  BasicSecondChoiceHashTable(size_t numBuckets, std::shared_ptr<HashFamily> family);
   
   /**
    * Cleans up all memory allocated by this hash table.
    */
-  ~SecondChoiceHashTable();
+  ~BasicSecondChoiceHashTable();
   
   /**
    * Inserts the specified element into this hash table. If the element already
@@ -46,11 +54,26 @@ public:
    */
   void remove(int key);
 
+  /**
+   * Batched lookup: sets out[i] to contains(keys[i]) for every i < n, after
+   * prefetching both buckets of a whole batch of keys (see Batch.h).
+   */
+  void contains_many(const int* keys, size_t n, bool* out) const;
+
+  /**
+   * Inserts keys[0], ..., keys[n - 1], prefetching their buckets a batch at
+   * a time.
+   */
+  void insert_many(const int* keys, size_t n);
+
   std::pair<size_t, size_t> indices_for_data(int data) const;
   
 private:
-  HashFunction hashFunction1;
-  HashFunction hashFunction2;
+  /* contains, given both buckets of data. */
+  bool contains_at(int data, std::pair<size_t, size_t> indices) const;
+
+  Hash hashFunction1;
+  Hash hashFunction2;
   std::vector<std::vector<int>> buckets;
   
   /* Fun with C++: these next two lines disable implicitly-generated copy
@@ -58,8 +81,11 @@ private:
    * implicitly copy an object of this type. You don't need to touch these
    * lines.
    */
-  SecondChoiceHashTable(SecondChoiceHashTable const &) = delete;
-  void operator=(SecondChoiceHashTable const &) = delete;
+  BasicSecondChoiceHashTable(BasicSecondChoiceHashTable const &) = delete;
+  void operator=(BasicSecondChoiceHashTable const &) = delete;
 };
  
+/* The type-erased table, usable with every hash family. */
+using SecondChoiceHashTable = BasicSecondChoiceHashTable<HashFunction>;
+
 #endif
@@ -0,0 +1,172 @@
+#include "Snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kMagic[8] = {'H', 'T', 'S', 'N', 'A', 'P', '\0', '\0'};
+
+/* A 64-bit checksum over a stream of bytes, eight at a time. It only has to
+ * catch truncated and corrupted files, not adversaries.
+ */
+class Checksum {
+public:
+  Checksum() : state(0x243F6A8885A308D3ull), pending(0), filled(0), total(0) {}
+
+  void update(const void* data, size_t n) {
+    const char* bytes = static_cast<const char*>(data);
+    total += n;
+    while (n > 0 && filled != 0) { // finish a word started by an earlier call
+      push(uint8_t(*bytes++));
+      n--;
+    }
+    for (; n >= 8; bytes += 8, n -= 8) {
+      uint64_t word;
+      std::memcpy(&word, bytes, sizeof(word));
+      mix(word);
+    }
+    while (n-- > 0) push(uint8_t(*bytes++));
+  }
+
+  uint64_t finish() {
+    if (filled != 0) mix(pending);
+    mix(total);
+    return state;
+  }
+
+private:
+  void push(uint8_t byte) {
+    pending |= uint64_t(byte) << (8 * filled);
+    if (++filled == 8) {
+      mix(pending);
+      pending = 0;
+      filled = 0;
+    }
+  }
+
+  void mix(uint64_t word) {
+    state = (state ^ word) * 0x9E3779B97F4A7C15ull;
+    state ^= state >> 32;
+  }
+
+  uint64_t state;
+  uint64_t pending;
+  size_t filled;
+  uint64_t total;
+};
+
+/* Where the buckets start, given everything that precedes them. */
+static uint64_t bucketOffset(size_t type_bytes, size_t hash_bytes, size_t counter_count) {
+  uint64_t end = sizeof(SnapshotHeader) + type_bytes + hash_bytes + counter_count * sizeof(uint64_t);
+  return (end + kSnapshotAlignment - 1) / kSnapshotAlignment * kSnapshotAlignment;
+}
+
+MappedFile::MappedFile(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("Can't open snapshot " + path);
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    throw std::runtime_error("Can't read snapshot " + path);
+  }
+  this->length = size_t(info.st_size);
+  void* mapping = mmap(nullptr, this->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd); // the mapping keeps the file open
+  if (mapping == MAP_FAILED) throw std::runtime_error("Can't map snapshot " + path);
+  this->address = static_cast<char*>(mapping);
+}
+
+MappedFile::~MappedFile() {
+  munmap(this->address, this->length);
+}
+
+void writeSnapshot(const std::string& path, const SnapshotContents& contents) {
+  SnapshotHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kSnapshotVersion;
+  header.type_bytes = uint32_t(contents.type.size());
+  header.hash_bytes = contents.hash_bytes;
+  header.counter_count = contents.counters.size();
+  header.bucket_count = contents.bucket_count;
+  header.bucket_bytes = contents.bucket_bytes;
+  header.bucket_offset = bucketOffset(contents.type.size(), contents.hash_bytes, contents.counters.size());
+
+  size_t padding = header.bucket_offset - sizeof(header) - contents.type.size() - contents.hash_bytes -
+                   contents.counters.size() * sizeof(uint64_t);
+  const char zeros[kSnapshotAlignment] = {};
+
+  Checksum checksum;
+  checksum.update(contents.type.data(), contents.type.size());
+  checksum.update(contents.hash, contents.hash_bytes);
+  checksum.update(contents.counters.data(), contents.counters.size() * sizeof(uint64_t));
+  checksum.update(zeros, padding);
+  checksum.update(contents.buckets, contents.bucket_count * contents.bucket_bytes);
+  header.checksum = checksum.finish();
+
+  // Write to a temporary file and rename it into place, so that a crash
+  // never leaves a half-written snapshot under the real name.
+  std::string temporary = path + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(contents.type.data(), contents.type.size());
+    out.write(static_cast<const char*>(contents.hash), contents.hash_bytes);
+    out.write(reinterpret_cast<const char*>(contents.counters.data()), contents.counters.size() * sizeof(uint64_t));
+    out.write(zeros, padding);
+    out.write(static_cast<const char*>(contents.buckets), contents.bucket_count * contents.bucket_bytes);
+    out.flush();
+    if (!out) throw std::runtime_error("Can't write snapshot " + temporary);
+  }
+  if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+    throw std::runtime_error("Can't move snapshot into place at " + path);
+  }
+}
+
+LoadedSnapshot readSnapshot(const std::string& path, const std::string& type, size_t hash_bytes,
+                            size_t bucket_bytes, bool verify) {
+  auto file = std::make_shared<MappedFile>(path);
+  auto fail = [&](const std::string& why) {
+    return std::runtime_error("Snapshot " + path + " " + why);
+  };
+
+  if (file->size() < sizeof(SnapshotHeader)) throw fail("is truncated");
+  SnapshotHeader header;
+  std::memcpy(&header, file->data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) throw fail("is not a snapshot");
+  if (header.version != kSnapshotVersion) throw fail("has an unsupported version");
+  if (header.type_bytes != type.size() || header.hash_bytes != hash_bytes ||
+      header.bucket_bytes != bucket_bytes ||
+      file->size() < sizeof(header) + type.size() ||
+      std::memcmp(file->data() + sizeof(header), type.data(), type.size()) != 0) {
+    throw fail("was saved by a different kind of table");
+  }
+  if (header.counter_count > file->size() ||
+      header.bucket_offset != bucketOffset(type.size(), hash_bytes, header.counter_count) ||
+      header.bucket_offset > file->size() ||
+      (file->size() - header.bucket_offset) / bucket_bytes != header.bucket_count ||
+      (file->size() - header.bucket_offset) % bucket_bytes != 0) {
+    throw fail("is truncated");
+  }
+  if (verify) {
+    Checksum checksum;
+    checksum.update(file->data() + sizeof(header), file->size() - sizeof(header));
+    if (checksum.finish() != header.checksum) throw fail("is corrupted");
+  }
+
+  LoadedSnapshot result;
+  const char* hash = file->data() + sizeof(header) + type.size();
+  result.hash = hash;
+  result.counters.resize(header.counter_count);
+  std::memcpy(result.counters.data(), hash + hash_bytes, header.counter_count * sizeof(uint64_t));
+  result.buckets = file->data() + header.bucket_offset;
+  result.bucket_count = header.bucket_count;
+  result.file = file;
+  return result;
+}
@@ -0,0 +1,139 @@
+#ifndef Snapshot_Included
+#define Snapshot_Included
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Snapshots: flat images of an open-addressing table on disk, which can be
+ * mapped back into memory instead of being rebuilt key by key.
+ *
+ * A snapshot file is laid out as
+ *
+ *    SnapshotHeader
+ *    the name of the table type, type_bytes long
+ *    the hash function's bytes, hash_bytes long
+ *    counter_count 64-bit counters the table keeps next to its buckets
+ *    padding up to bucket_offset, a multiple of kSnapshotAlignment
+ *    the bucket array, bucket_count buckets of bucket_bytes each
+ *
+ * with the checksum in the header covering everything after the header. The
+ * type name pins down the table, its hasher and its policies, so a snapshot
+ * can only be loaded into the kind of table that saved it. Buckets and hash
+ * functions are written in the machine's own byte order and struct layout:
+ * a snapshot is meant to be loaded by the program that wrote it.
+ *
+ * Loading maps the file privately and copy-on-write. Lookups read the
+ * mapped pages directly, so a cold start costs a page fault per page
+ * touched; a table that is written to afterwards only copies the pages it
+ * changes, and the file is never modified.
+ */
+static const uint32_t kSnapshotVersion = 2; // 2: 32-bit Robin Hood probe distances
+static const size_t kSnapshotAlignment = 64;
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t type_bytes;
+  uint64_t hash_bytes;
+  uint64_t counter_count;
+  uint64_t bucket_count;
+  uint64_t bucket_bytes;
+  uint64_t bucket_offset;
+  uint64_t checksum;
+};
+
+/**
+ * A whole file, mapped readable and writable but private: a table loaded
+ * from it may go on changing its buckets in place, and each page it writes
+ * to becomes a copy of its own, so the file itself is never modified.
+ * Unmapped when the last BucketArray using it goes away.
+ */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  char* data() const { return address; }
+  size_t size() const { return length; }
+
+private:
+  char* address;
+  size_t length;
+
+  MappedFile(MappedFile const &) = delete;
+  void operator=(MappedFile const &) = delete;
+};
+
+/**
+ * The bucket array of a table that can be saved and loaded. It either owns
+ * its buckets, like a std::vector, or views buckets inside a MappedFile
+ * that it keeps alive.
+ */
+template <typename T>
+class BucketArray {
+public:
+  BucketArray() : first(nullptr), count(0) {}
+  BucketArray(size_t n, const T& value) : owned(n, value), first(owned.data()), count(n) {}
+  BucketArray(std::shared_ptr<MappedFile> file, T* first, size_t n) : file(file), first(first), count(n) {}
+
+  BucketArray(BucketArray&&) = default;
+  BucketArray& operator=(BucketArray&&) = default;
+
+  size_t size() const { return count; }
+  T& operator[](size_t index) { return first[index]; }
+  const T& operator[](size_t index) const { return first[index]; }
+  T* begin() { return first; }
+  T* end() { return first + count; }
+  const T* data() const { return first; }
+
+private:
+  std::vector<T> owned;
+  std::shared_ptr<MappedFile> file;
+  T* first;
+  size_t count;
+
+  BucketArray(BucketArray const &) = delete;
+  void operator=(BucketArray const &) = delete;
+};
+
+/* What a table writes out, and what it gets back when loading. */
+struct SnapshotContents {
+  std::string type;
+  const void* hash;
+  size_t hash_bytes;
+  std::vector<uint64_t> counters;
+  const void* buckets;
+  size_t bucket_count;
+  size_t bucket_bytes;
+};
+
+struct LoadedSnapshot {
+  std::shared_ptr<MappedFile> file;
+  const void* hash;
+  std::vector<uint64_t> counters;
+  void* buckets;
+  size_t bucket_count;
+};
+
+/**
+ * Writes a snapshot of the given contents to path. Throws std::runtime_error
+ * if the file can't be written.
+ */
+void writeSnapshot(const std::string& path, const SnapshotContents& contents);
+
+/**
+ * Maps the snapshot at path and checks that it was written by a table of the
+ * given type with hash functions of hash_bytes bytes and buckets of
+ * bucket_bytes bytes; the table checks its own counters. If verify is set,
+ * the checksum of the whole file is checked as well, which reads every page
+ * of it. Throws std::runtime_error if the file can't be mapped or doesn't
+ * match.
+ */
+LoadedSnapshot readSnapshot(const std::string& path, const std::string& type, size_t hash_bytes,
+                            size_t bucket_bytes, bool verify);
+
+#endif
@@ -0,0 +1,243 @@
+#include "SwissHashTable.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const int8_t EMPTY = -128;
+static const int8_t DELETED = -2;
+static const size_t npos = size_t(-1);
+
+/* Group operations
+ * ----------------------------------------------------------------------------
+ * Each function compares all control bytes of the group starting at 'group'
+ * and returns a bitmask with bit i set if slot i of the group matched.
+ */
+#if defined(__AVX2__)
+
+static const size_t kGroupWidth = 32;
+
+static inline uint32_t match_byte(const int8_t* group, int8_t value) {
+  __m256i ctrl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(group));
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8(value)));
+}
+
+static inline uint32_t match_empty_or_deleted(const int8_t* group) {
+  // EMPTY and DELETED are the only negative control bytes.
+  __m256i ctrl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(group));
+  return _mm256_movemask_epi8(ctrl);
+}
+
+#elif defined(__SSE2__)
+
+static const size_t kGroupWidth = 16;
+
+static inline uint32_t match_byte(const int8_t* group, int8_t value) {
+  __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value)));
+}
+
+static inline uint32_t match_empty_or_deleted(const int8_t* group) {
+  // EMPTY and DELETED are the only negative control bytes.
+  __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return _mm_movemask_epi8(ctrl);
+}
+
+#else
+
+static const size_t kGroupWidth = 16;
+
+static inline uint32_t match_byte(const int8_t* group, int8_t value) {
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupWidth; i++) {
+    if (group[i] == value) mask |= uint32_t(1) << i;
+  }
+  return mask;
+}
+
+static inline uint32_t match_empty_or_deleted(const int8_t* group) {
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupWidth; i++) {
+    if (group[i] < 0) mask |= uint32_t(1) << i;
+  }
+  return mask;
+}
+
+#endif
+
+/* Once more than 1 / kMaxDeletedFraction of the slots are DELETED, remove
+ * rehashes the table in place so that lookups find EMPTY slots again.
+ */
+static const size_t kMaxDeletedFraction = 8;
+
+/* The tag is the top 7 bits of the hash times 2^64 / phi. Taking fixed bits
+ * of the hash would not do: the polynomial families fill only 31 bits and
+ * identityHash only as many as the key has, so a fixed field is all zeroes
+ * for small keys under identityHash. The multiplication folds every bit of
+ * the hash into the top ones, which the group index never looks at.
+ */
+static inline int8_t tag_for_hash(size_t hash_value) {
+  return int8_t((uint64_t(hash_value) * 0x9E3779B97F4A7C15ull) >> 57);
+}
+
+template <typename Hash, typename Capacity, typename Key>
+BasicSwissHashTable<Hash, Capacity, Key>::BasicSwissHashTable(size_t numBuckets, std::shared_ptr<BasicHashFamily<Key>> family)
+{
+  this->hashFunction = sampleHash<Hash>(family);
+  this->groups = Capacity((numBuckets + kGroupWidth - 1) / kGroupWidth);
+  this->control = std::vector<int8_t>(this->groups.size() * kGroupWidth, EMPTY);
+  this->slots.resize(this->groups.size() * kGroupWidth);
+  this->deleted = 0;
+}
+
+template <typename Hash, typename Capacity, typename Key>
+BasicSwissHashTable<Hash, Capacity, Key>::~BasicSwissHashTable()
+{
+  for (size_t slot = 0; slot < this->slots.size(); slot++) {
+    if (this->control[slot] >= 0) KeyTraits<Key>::release(this->slots[slot]);
+  }
+}
+
+template <typename Hash, typename Capacity, typename Key>
+size_t BasicSwissHashTable<Hash, Capacity, Key>::find(const Key& data, size_t hash_value) const
+{
+  int8_t tag = tag_for_hash(hash_value);
+  size_t group = this->groups.index(hash_value);
+  for (size_t probes = 0; probes < this->groups.size(); probes++) {
+    const int8_t* ctrl = &this->control[group * kGroupWidth];
+    for (uint32_t mask = match_byte(ctrl, tag); mask != 0; mask &= mask - 1) {
+      size_t slot = group * kGroupWidth + __builtin_ctz(mask);
+      if (KeyTraits<Key>::matches(this->slots[slot], data, hash_value)) return slot;
+    }
+    if (match_byte(ctrl, EMPTY)) return npos; // key would have been placed here
+    group = this->groups.next(group);
+  }
+  return npos;
+}
+
+template <typename Hash, typename Capacity, typename Key>
+void BasicSwissHashTable<Hash, Capacity, Key>::insert(const Key& data)
+{
+  insert_hashed(data, this->hashFunction(data));
+}
+
+template <typename Hash, typename Capacity, typename Key>
+size_t BasicSwissHashTable<Hash, Capacity, Key>::free_slot(size_t hash_value) const
+{
+  size_t group = this->groups.index(hash_value);
+  for (size_t probes = 0; probes < this->groups.size(); probes++) {
+    uint32_t mask = match_empty_or_deleted(&this->control[group * kGroupWidth]);
+    if (mask) return group * kGroupWidth + __builtin_ctz(mask);
+    group = this->groups.next(group);
+  }
+  return npos;
+}
+
+template <typename Hash, typename Capacity, typename Key>
+void BasicSwissHashTable<Hash, Capacity, Key>::insert_hashed(const Key& data, size_t hash_value)
+{
+  if (this->find(data, hash_value) != npos) return; // don't insert duplicate
+
+  size_t slot = free_slot(hash_value);
+  if (slot == npos) throw std::length_error("SwissHashTable: every slot holds a key");
+  if (this->control[slot] == DELETED) this->deleted--;
+  this->control[slot] = tag_for_hash(hash_value);
+  this->slots[slot] = KeyTraits<Key>::store(data, hash_value);
+}
+
+template <typename Hash, typename Capacity, typename Key>
+bool BasicSwissHashTable<Hash, Capacity, Key>::contains(const Key& data) const
+{
+  return this->find(data, this->hashFunction(data)) != npos;
+}
+
+template <typename Hash, typename Capacity, typename Key>
+void BasicSwissHashTable<Hash, Capacity, Key>::remove(const Key& data)
+{
+  size_t slot = this->find(data, this->hashFunction(data));
+  if (slot == npos) return;
+
+  KeyTraits<Key>::release(this->slots[slot]);
+  const int8_t* ctrl = &this->control[slot - slot % kGroupWidth];
+  if (match_byte(ctrl, EMPTY)) {
+    this->control[slot] = EMPTY;
+    return;
+  }
+  this->control[slot] = DELETED;
+  if (++this->deleted > this->slots.size() / kMaxDeletedFraction) rehash_in_place();
+}
+
+template <typename Hash, typename Capacity, typename Key>
+void BasicSwissHashTable<Hash, Capacity, Key>::rehash_in_place()
+{
+  /* Take the keys out, mark every slot EMPTY and put the keys back. The
+   * slots move as they are; nothing is stored or released again.
+   */
+  std::vector<typename KeyTraits<Key>::Slot> live;
+  for (size_t slot = 0; slot < this->slots.size(); slot++) {
+    if (this->control[slot] >= 0) live.push_back(this->slots[slot]);
+  }
+  std::fill(this->control.begin(), this->control.end(), EMPTY);
+  this->deleted = 0;
+
+  for (const auto& entry : live) {
+    size_t hash_value = this->hashFunction(KeyTraits<Key>::key(entry));
+    size_t slot = free_slot(hash_value);
+    this->control[slot] = tag_for_hash(hash_value);
+    this->slots[slot] = entry;
+  }
+}
+
+template <typename Hash, typename Capacity, typename Key>
+void BasicSwissHashTable<Hash, Capacity, Key>::contains_many(const Key* keys, size_t n, bool* out) const
+{
+  size_t hashes[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction, keys + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      prefetch_group(hashes[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      out[start + i] = this->find(keys[start + i], hashes[i]) != npos;
+    }
+  }
+}
+
+template <typename Hash, typename Capacity, typename Key>
+void BasicSwissHashTable<Hash, Capacity, Key>::insert_many(const Key* keys, size_t n)
+{
+  size_t hashes[kBatchSize];
+  for (size_t start = 0; start < n; start += kBatchSize) {
+    size_t count = std::min(kBatchSize, n - start);
+    hashMany(this->hashFunction, keys + start, count, hashes);
+    for (size_t i = 0; i < count; i++) {
+      prefetch_group(hashes[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      insert_hashed(keys[start + i], hashes[i]);
+    }
+  }
+}
+
+template <typename Hash, typename Capacity, typename Key>
+inline void BasicSwissHashTable<Hash, Capacity, Key>::prefetch_group(size_t hash_value) const
+{
+  size_t slot = this->groups.index(hash_value) * kGroupWidth;
+  prefetch(&this->control[slot]);
+  prefetch(&this->slots[slot]);
+}
+
+#define INSTANTIATE(Hash, Capacity) template class BasicSwissHashTable<Hash, Capacity>;
+#define INSTANTIATE_ALL_CAPACITIES(Hash) FOR_EACH_CAPACITY(INSTANTIATE, Hash)
+FOR_EACH_HASH(INSTANTIATE_ALL_CAPACITIES)
+
+#define INSTANTIATE_UINT64(Hash) template class BasicSwissHashTable<Hash, ModuloCapacity, uint64_t>;
+#define INSTANTIATE_STRING(Hash) template class BasicSwissHashTable<Hash, ModuloCapacity, std::string>;
+FOR_EACH_UINT64_HASH(INSTANTIATE_UINT64)
+FOR_EACH_STRING_HASH(INSTANTIATE_STRING)
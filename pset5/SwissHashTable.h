@@ -0,0 +1,127 @@
+#ifndef SwissHashTable_Included
+#define SwissHashTable_Included
+
+#include "Hashes.h"
+#include "Capacity.h"
+#include "Batch.h"
+#include "Keys.h"
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * An open-addressing table in the style of Google's "Swiss tables". Slots are
+ * grouped, and next to every slot sits a control byte holding either EMPTY,
+ * DELETED or a 7-bit tag taken from the key's hash. A lookup compares the
+ * tag against a whole group of control bytes at once and only looks at the
+ * keys whose tags match. Since emptiness lives in the control bytes, every
+ * int can be stored as a key.
+ *
+ * The group width is fixed when the table is compiled, since it shapes the
+ * layout of the control bytes: 32 when the compiler may use AVX2, 16 with
+ * SSE2 otherwise. The Makefile's flags don't enable AVX2, so run-tests times
+ * 16-wide groups unless built with, say,
+ *
+ *    make CXXFLAGS="-std=c++11 -Wall -Werror -O3 -pthread -mavx2"
+ *
+ * Like the other tables it is templated on its hash function, and on a
+ * Capacity policy (see Capacity.h) that maps hashes onto groups. It is also
+ * templated on its key type, int by default: the slots hold keys as
+ * KeyTraits<Key> (see Keys.h) lays them out, inline for fixed-size keys and
+ * as a fingerprint plus a pointer for strings. Hash must accept a Key, and
+ * the family passed in must be a BasicHashFamily<Key>.
+ */
+template <typename Hash, typename Capacity = ModuloCapacity, typename Key = int>
+class BasicSwissHashTable {
+public:
+  /**
+   * Constructs a new Swiss table with at least the specified number of
+   * buckets, using hash functions drawn from the indicated family of hash
+   * functions. The bucket count is rounded up to a whole number of groups.
+   * Because our testing harness attempts to exercise a number of different
+   * load factors, the table never changes its number of buckets.
+   */
+  BasicSwissHashTable(size_t numBuckets, std::shared_ptr<BasicHashFamily<Key>> family);
+
+  /**
+   * Cleans up all memory allocated by this hash table.
+   */
+  ~BasicSwissHashTable();
+
+  /**
+   * Inserts the specified element into this hash table. If the element already
+   * exists, this operation is a no-op. Throws std::length_error if every slot
+   * already holds a key.
+   */
+  void insert(const Key& key);
+
+  /**
+   * Returns whether the specified key is contained in this hash table.
+   */
+  bool contains(const Key& key) const;
+
+  /**
+   * Removes the specified element from this hash table. If the element is not
+   * present in the hash table, this operation is a no-op.
+   *
+   * A removed slot becomes EMPTY again if its group still contains an EMPTY
+   * slot, since then no probe sequence can have continued past the group.
+   * Otherwise it is marked DELETED, and once DELETED slots make up an eighth
+   * of the table, every key is rehashed in place and they all become EMPTY.
+   */
+  void remove(const Key& key);
+
+  /**
+   * Batched lookup: sets out[i] to contains(keys[i]) for every i < n. For a
+   * whole batch of keys, the control bytes and slots of the first group are
+   * prefetched before any group is scanned (see Batch.h).
+   */
+  void contains_many(const Key* keys, size_t n, bool* out) const;
+
+  /**
+   * Inserts keys[0], ..., keys[n - 1], prefetching their first groups a
+   * batch at a time.
+   */
+  void insert_many(const Key* keys, size_t n);
+
+private:
+  /* Returns the slot holding key, or npos if key isn't present. */
+  size_t find(const Key& key, size_t hash_value) const;
+
+  /* insert, given the hash of data. */
+  void insert_hashed(const Key& data, size_t hash_value);
+
+  /* The first EMPTY or DELETED slot in the probe sequence for this hash, or
+   * npos if every slot holds a key.
+   */
+  size_t free_slot(size_t hash_value) const;
+
+  /* Reinserts every key into the same slots, turning DELETED slots EMPTY. */
+  void rehash_in_place();
+
+  /* Prefetches the first group that a key with this hash is looked for in. */
+  void prefetch_group(size_t hash_value) const;
+
+  std::vector<int8_t> control;
+  std::vector<typename KeyTraits<Key>::Slot> slots;
+  Capacity groups;
+  Hash hashFunction;
+  size_t deleted; // the number of DELETED slots
+
+  /* Fun with C++: these next two lines disable implicitly-generated copy
+   * functions that would otherwise cause weird errors if you tried to
+   * implicitly copy an object of this type. You don't need to touch these
+   * lines.
+   */
+  BasicSwissHashTable(BasicSwissHashTable const &) = delete;
+  void operator=(BasicSwissHashTable const &) = delete;
+};
+
+/* The type-erased table, usable with every hash family. */
+using SwissHashTable = BasicSwissHashTable<HashFunction>;
+
+/* Type-erased tables for 64-bit and for string keys. */
+using Uint64SwissHashTable = BasicSwissHashTable<BasicHashFunction<uint64_t>, ModuloCapacity, uint64_t>;
+using StringSwissHashTable = BasicSwissHashTable<BasicHashFunction<std::string>, ModuloCapacity, std::string>;
+
+#endif
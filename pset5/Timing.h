@@ -1,16 +1,33 @@
 #ifndef Timing_Included
 #define Timing_Included
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
 #include <random>
 #include <tuple>
+#include <functional>
 #include <memory>
 #include <initializer_list>
+#include <unordered_map>
 #include <unordered_set>
 #include <iostream>
 #include <iomanip>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
 
 #include "Hashes.h"
+#include "Capacity.h"
+#include "Batch.h"
+#include "Histogram.h"
+#include "Results.h"
+#include "PerfCounters.h"
+#include "Workloads.h"
 
 /* The random seed used throughout the run. */
 static const size_t kRandomSeed = 138;
@@ -20,35 +37,106 @@ static const size_t kRandomSeed = 138;
  */
 static const size_t kSpread = 4;
 
+/**
+ * Print the heading of a section of the run, of a hash family or of a load
+ * factor, and tell the ResultLog (see Results.h) what the results that
+ * follow belong to.
+ */
+inline void printSection(const std::string& name) {
+  std::cout << "#### " << name << " ####" << std::endl;
+  ResultLog::current().section(name);
+}
+
+inline void printFamily(const std::string& name) {
+  std::cout << "=== " << name << " ===" << std::endl;
+  ResultLog::current().setFamily(name);
+}
+
+inline void printLoadFactor(double loadFactor) {
+  std::cout << "  --- Load Factor: " << std::fixed << std::setw(8) << std::setprecision(5) << loadFactor << " ---" << std::endl;
+  ResultLog::current().setLoadFactor(loadFactor);
+}
+
+/**
+ * Print the hardware counts per operation of the last timing, if the
+ * counters are enabled (see PerfCounters.h).
+ */
+inline void printCounters() {
+  for (const auto& reading : PerfCounters::current().takeReadings()) {
+    std::cout << "    " << std::left << std::setw(11) << reading.first + ":" << std::right
+              << PerfCounters::describe(reading.second) << " / op" << std::endl;
+  }
+}
+
+/* Where snapshots are written while they are checked and timed. */
+static const char* const kSnapshotPath = "run-tests.snapshot";
+
+/**
+ * Turn the integer n into a key of type Key, injectively: 64-bit keys are
+ * spread over the whole 64-bit range like real IDs, and string keys look
+ * like short identifiers.
+ */
+template <typename Key>
+Key makeKey(int n);
+
+template <>
+inline uint64_t makeKey<uint64_t>(int n) {
+  return uint64_t(uint32_t(n)) * 0x9E3779B97F4A7C15ull;
+}
+
+template <>
+inline std::string makeKey<std::string>(int n) {
+  return "user:" + std::to_string(n);
+}
+
 /**
  * Gather timing information for performing a certain number of actions.
- * The elements used are provided by the given generator.
+ * The elements used are provided by the given generator. If given, inspect
+ * is called on the table once all actions have been timed. With the
+ * hardware counters enabled, the insertions and the queries are also
+ * counted (see PerfCounters.h), for printCounters to report.
  */
 template <typename F, typename HT>
 std::tuple<double, double> timeGenerator(double loadFactor, 
-                                         std::shared_ptr<HashFamily> family, F& gen, size_t numActions) {
+                                         std::shared_ptr<HashFamily> family, F& gen, size_t numActions,
+                                         std::function<void(const HT&)> inspect = nullptr) {
   std::default_random_engine engine(kRandomSeed);
   
   HT table(numActions + 2, family); // The +2 term ensures that cuckoo hashing rounds the right way.
 
   std::chrono::high_resolution_clock::duration totalInsertion = std::chrono::high_resolution_clock::duration::zero();
   std::chrono::high_resolution_clock::duration totalQuery = std::chrono::high_resolution_clock::duration::zero();
-  
-  for (size_t i = 0; i < numActions * loadFactor; ++i) {
+
+  // The counters' second pass draws the same keys and reads the clock, but
+  // leaves out the table.
+  std::default_random_engine overheadEngine = engine;
+  std::chrono::high_resolution_clock::duration totalOverhead = std::chrono::high_resolution_clock::duration::zero();
+  auto overhead = [&](size_t) {
+    int value = gen(overheadEngine);
+    auto start = std::chrono::high_resolution_clock::now();
+    keepAlive(value);
+    auto end = std::chrono::high_resolution_clock::now();
+    totalOverhead += end - start;
+  };
+  PerfCounters::current().clearReadings();
+
+  countOperations("Insertion", size_t(std::ceil(numActions * loadFactor)), [&](size_t) {
     int value = gen(engine);
     auto start = std::chrono::high_resolution_clock::now();
     table.insert(value);
     auto end = std::chrono::high_resolution_clock::now();
     totalInsertion += end - start;
-  }
-  
-  for (size_t i = 0; i < numActions; i++) {
+  }, overhead);
+
+  countOperations("Query", numActions, [&](size_t) {
     int value = gen(engine);
     auto start = std::chrono::high_resolution_clock::now();
     table.contains(value);
     auto end = std::chrono::high_resolution_clock::now();
     totalQuery += end - start;
-  }
+  }, overhead);
+
+  if (inspect) inspect(table);
   
   double insertionNS = std::chrono::duration_cast<std::chrono::nanoseconds>(totalInsertion).count() / (double) numActions;
   double queryNS = std::chrono::duration_cast<std::chrono::nanoseconds>(totalQuery).count() / (double) numActions;
@@ -96,6 +184,9 @@ void report(double loadFactor, std::shared_ptr<HashFamily> family){
             << std::get<0>(times) << " ns / op" << std::endl;
   std::cout << "    Query:     " << std::fixed << std::setw(8) << std::setprecision(2) 
             << std::get<1>(times) << " ns / op" << std::endl;
+  ResultLog::current().record("Insertion", std::get<0>(times));
+  ResultLog::current().record("Query", std::get<1>(times));
+  printCounters();
 }
 
 template <typename HT>
@@ -106,15 +197,756 @@ void doAllReports(std::shared_ptr<HashFamily> family, double loadFactor) {
 template <typename HT>
 void doAllReports(std::initializer_list<std::shared_ptr<HashFamily>> factories, std::initializer_list<double> loadFactors) {
   for (auto family : factories) {
-    std::cout << "=== " << family->name() << " ===" << std::endl;
+    printFamily(family->name());
     for (auto loadFactor : loadFactors) {
-      std::cout << "  --- Load Factor: " << std::fixed << std::setw(8) << std::setprecision(5) << loadFactor << " ---" << std::endl;
+      printLoadFactor(loadFactor);
       doAllReports<HT>(family, loadFactor);
     }
   }
 }
 
 
+/**
+ * Print timing information for the same table instantiated twice: once with
+ * the type-erased HashFunction and once with the concrete hasher Hash, which
+ * the compiler can inline into the probe loop. The family must be a
+ * TypedHashFamily<Hash>.
+ */
+template <template <typename...> class HT, typename Hash>
+void reportHashDispatch(std::shared_ptr<HashFamily> family, std::initializer_list<double> loadFactors) {
+  printFamily(family->name());
+  for (auto loadFactor : loadFactors) {
+    printLoadFactor(loadFactor);
+    auto erased  = time100k<HT<HashFunction>>(loadFactor, family);
+    auto inlined = time100k<HT<Hash>>(loadFactor, family);
+    std::cout << "    Insertion: " << std::fixed << std::setw(8) << std::setprecision(2)
+              << std::get<0>(erased) << " ns / op (std::function), "
+              << std::setw(8) << std::get<0>(inlined) << " ns / op (inlined)" << std::endl;
+    std::cout << "    Query:     " << std::fixed << std::setw(8) << std::setprecision(2)
+              << std::get<1>(erased) << " ns / op (std::function), "
+              << std::setw(8) << std::get<1>(inlined) << " ns / op (inlined)" << std::endl;
+    ResultLog::current().record("Insertion (std::function)", std::get<0>(erased));
+    ResultLog::current().record("Insertion (inlined)", std::get<0>(inlined));
+    ResultLog::current().record("Query (std::function)", std::get<1>(erased));
+    ResultLog::current().record("Query (inlined)", std::get<1>(inlined));
+  }
+}
+
+/**
+ * Compare type-erased and inlined hashing for every hash family. The
+ * single-function families (identity and Jenkins) are only included when
+ * the table can work with a single hash function.
+ */
+template <template <typename...> class HT>
+void doHashDispatchReports(std::initializer_list<double> loadFactors, bool includeSingleFunctions) {
+  reportHashDispatch<HT, TwoIndependentHash>(twoIndependentHashFamily(), loadFactors);
+  reportHashDispatch<HT, ThreeIndependentHash>(threeIndependentHashFamily(), loadFactors);
+  reportHashDispatch<HT, FiveIndependentHash>(fiveIndependentHashFamily(), loadFactors);
+  reportHashDispatch<HT, MultiplyShiftHash>(multiplyShiftHashFamily(), loadFactors);
+  reportHashDispatch<HT, MersenneThreeIndependentHash>(mersenneThreeIndependentHashFamily(), loadFactors);
+  reportHashDispatch<HT, MersenneFiveIndependentHash>(mersenneFiveIndependentHashFamily(), loadFactors);
+  reportHashDispatch<HT, TabulationHash>(tabulationHashFamily(), loadFactors);
+  reportHashDispatch<HT, CompactTabulationHash>(compactTabulationHashFamily(), loadFactors);
+  if (includeSingleFunctions) {
+    reportHashDispatch<HT, IdentityHash>(identityHash(), loadFactors);
+    reportHashDispatch<HT, JenkinsHash>(jenkinsHash(), loadFactors);
+  }
+}
+
+
+/**
+ * Time a hash function on its own: numKeys random keys hashed one call at a
+ * time, then the same keys hashed kBatchSize at a time through hashMany.
+ * Returns the nanoseconds per key of both.
+ */
+template <typename Hash>
+std::tuple<double, double> timeHashing(std::shared_ptr<HashFamily> family, size_t numKeys) {
+  std::default_random_engine engine(kRandomSeed);
+  std::uniform_int_distribution<int> gen;
+  Hash hash = sampleHash<Hash>(family);
+  std::vector<int> keys(numKeys);
+  for (auto& key : keys) key = gen(engine);
+  std::vector<size_t> hashes(numKeys);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < numKeys; i++) hashes[i] = hash(keys[i]);
+  auto middle = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < numKeys; i += kBatchSize) {
+    hashMany(hash, keys.data() + i, std::min(kBatchSize, numKeys - i), hashes.data() + i);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+
+  std::chrono::duration<double, std::nano> single = middle - start;
+  std::chrono::duration<double, std::nano> batched = end - middle;
+  return std::make_tuple(single.count() / numKeys, batched.count() / numKeys);
+}
+
+template <typename Hash>
+void reportHashing(std::shared_ptr<HashFamily> family, size_t numKeys) {
+  auto times = timeHashing<Hash>(family, numKeys);
+  printFamily(family->name());
+  std::cout << "    Hashing:   " << std::fixed << std::setw(8) << std::setprecision(2)
+            << std::get<0>(times) << " ns / key (one at a time), "
+            << std::setw(8) << std::get<1>(times) << " ns / key (hashMany)" << std::endl;
+  ResultLog::current().record("Hashing (one at a time)", std::get<0>(times));
+  ResultLog::current().record("Hashing (hashMany)", std::get<1>(times));
+}
+
+/**
+ * Compare the cost of evaluating each hash family, one key at a time and in
+ * batches.
+ */
+inline void doHashingReports(size_t numKeys) {
+  reportHashing<TwoIndependentHash>(twoIndependentHashFamily(), numKeys);
+  reportHashing<ThreeIndependentHash>(threeIndependentHashFamily(), numKeys);
+  reportHashing<FiveIndependentHash>(fiveIndependentHashFamily(), numKeys);
+  reportHashing<MultiplyShiftHash>(multiplyShiftHashFamily(), numKeys);
+  reportHashing<MersenneThreeIndependentHash>(mersenneThreeIndependentHashFamily(), numKeys);
+  reportHashing<MersenneFiveIndependentHash>(mersenneFiveIndependentHashFamily(), numKeys);
+  reportHashing<TabulationHash>(tabulationHashFamily(), numKeys);
+  reportHashing<CompactTabulationHash>(compactTabulationHashFamily(), numKeys);
+  reportHashing<JenkinsHash>(jenkinsHash(), numKeys);
+}
+
+/**
+ * Print timing information for the same table under each capacity policy from
+ * Capacity.h. PowerOfTwoCapacity rounds the bucket count up, so its effective
+ * load factor may be lower than the one reported.
+ */
+template <template <typename...> class HT>
+void doCapacityReports(std::initializer_list<std::shared_ptr<HashFamily>> factories, std::initializer_list<double> loadFactors) {
+  for (auto family : factories) {
+    printFamily(family->name());
+    for (auto loadFactor : loadFactors) {
+      printLoadFactor(loadFactor);
+      std::cout << "   Modulo:" << std::endl;
+      ResultLog::current().setVariant("Modulo");
+      report<time100k<HT<HashFunction, ModuloCapacity>>>(loadFactor, family);
+      std::cout << "   Power of two:" << std::endl;
+      ResultLog::current().setVariant("Power of two");
+      report<time100k<HT<HashFunction, PowerOfTwoCapacity>>>(loadFactor, family);
+      std::cout << "   Fast range:" << std::endl;
+      ResultLog::current().setVariant("Fast range");
+      report<time100k<HT<HashFunction, FastRangeCapacity>>>(loadFactor, family);
+    }
+  }
+}
+
+
+/**
+ * Print timing information for a cuckoo table, followed by how many times it
+ * had to rehash and which fraction of the queries was answered from its stash.
+ */
+template <typename HT>
+void doStashReports(std::initializer_list<std::shared_ptr<HashFamily>> factories, std::initializer_list<double> loadFactors) {
+  const size_t numActions = 100000;
+  for (auto family : factories) {
+    printFamily(family->name());
+    for (auto loadFactor : loadFactors) {
+      printLoadFactor(loadFactor);
+      typename HT::Stats stats;
+      auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+      auto times = timeGenerator<decltype(gen), HT>(loadFactor, family, gen, numActions,
+                                                    [&](const HT& table) { stats = table.stats(); });
+      std::cout << "    Insertion: " << std::fixed << std::setw(8) << std::setprecision(2)
+                << std::get<0>(times) << " ns / op" << std::endl;
+      std::cout << "    Query:     " << std::fixed << std::setw(8) << std::setprecision(2)
+                << std::get<1>(times) << " ns / op" << std::endl;
+      ResultLog::current().record("Insertion", std::get<0>(times));
+      ResultLog::current().record("Query", std::get<1>(times));
+      printCounters();
+      std::cout << "    Rehashes:  " << std::setw(8) << stats.rehashes << std::endl;
+      std::cout << "    Stash:     " << std::setw(8) << stats.stash_size << " elements, "
+                << std::setprecision(4) << 100.0 * stats.stash_hits / numActions << "% of queries" << std::endl;
+    }
+  }
+}
+
+
+/**
+ * Print timing information for a growable table that starts out tiny and is
+ * filled with 100,000 keys. The slowest single insertion is reported as well,
+ * since avoiding a stop-the-world rehash is the point of growing incrementally.
+ */
+template <typename HT>
+void doGrowthReports(std::initializer_list<std::shared_ptr<HashFamily>> factories) {
+  const size_t numActions = 100000;
+  for (auto family : factories) {
+    printFamily(family->name());
+    std::default_random_engine engine(kRandomSeed);
+    auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+    HT table(16, family);
+
+    std::chrono::high_resolution_clock::duration totalInsertion = std::chrono::high_resolution_clock::duration::zero();
+    std::chrono::high_resolution_clock::duration maxInsertion = std::chrono::high_resolution_clock::duration::zero();
+    std::chrono::high_resolution_clock::duration totalQuery = std::chrono::high_resolution_clock::duration::zero();
+    for (size_t i = 0; i < numActions; i++) {
+      int value = gen(engine);
+      auto start = std::chrono::high_resolution_clock::now();
+      table.insert(value);
+      auto end = std::chrono::high_resolution_clock::now();
+      totalInsertion += end - start;
+      maxInsertion = std::max(maxInsertion, end - start);
+    }
+    for (size_t i = 0; i < numActions; i++) {
+      int value = gen(engine);
+      auto start = std::chrono::high_resolution_clock::now();
+      table.contains(value);
+      auto end = std::chrono::high_resolution_clock::now();
+      totalQuery += end - start;
+    }
+
+    std::cout << "    Insertion: " << std::fixed << std::setw(8) << std::setprecision(2)
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(totalInsertion).count() / (double) numActions
+              << " ns / op, slowest " << std::chrono::duration_cast<std::chrono::nanoseconds>(maxInsertion).count() << " ns" << std::endl;
+    std::cout << "    Query:     " << std::fixed << std::setw(8) << std::setprecision(2)
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(totalQuery).count() / (double) numActions
+              << " ns / op" << std::endl;
+    std::cout << "    Keys:      " << std::setw(8) << table.size() << std::endl;
+    ResultLog::current().record("Insertion", std::chrono::duration<double, std::nano>(totalInsertion).count() / numActions);
+    ResultLog::current().record("Query", std::chrono::duration<double, std::nano>(totalQuery).count() / numActions);
+  }
+}
+
+
+/**
+ * Gather throughput and latency information for the same operations as
+ * timeAbsolute, without paying for a clock read around every one of them.
+ *
+ * The operations are run in chunks of kLatencyChunk. Most chunks are timed
+ * as a whole, which gives the throughput. Every kLatencySampling-th chunk
+ * instead times each of its operations on its own, minus the cost of reading
+ * the clock, into a LatencyHistogram. Those chunks are left out of the
+ * throughput, so the clock reads don't inflate it.
+ */
+static const size_t kLatencyChunk = 1000;
+static const size_t kLatencySampling = 8;
+
+struct LatencyReport {
+  double throughputNS;
+  LatencyHistogram latencies;
+};
+
+/* The cost of reading the clock twice in a row, which every single-operation
+ * sample includes. The median of many attempts, so that a stray interrupt
+ * doesn't count.
+ */
+inline uint64_t clockOverheadNS() {
+  static const uint64_t overhead = [] {
+    std::vector<int64_t> attempts(10001);
+    for (auto& attempt : attempts) {
+      auto start = std::chrono::high_resolution_clock::now();
+      auto end = std::chrono::high_resolution_clock::now();
+      attempt = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    }
+    std::nth_element(attempts.begin(), attempts.begin() + attempts.size() / 2, attempts.end());
+    return uint64_t(std::max<int64_t>(0, attempts[attempts.size() / 2]));
+  }();
+  return overhead;
+}
+
+template <typename F>
+LatencyReport timeOperations(const std::vector<int>& keys, F operation) {
+  LatencyReport report;
+  uint64_t overhead = clockOverheadNS();
+  std::chrono::high_resolution_clock::duration total = std::chrono::high_resolution_clock::duration::zero();
+  size_t timedInBulk = 0;
+
+  for (size_t start = 0, chunk = 0; start < keys.size(); start += kLatencyChunk, chunk++) {
+    size_t end = std::min(keys.size(), start + kLatencyChunk);
+    if (chunk % kLatencySampling == kLatencySampling - 1) {
+      for (size_t i = start; i < end; i++) {
+        auto before = std::chrono::high_resolution_clock::now();
+        operation(keys[i]);
+        auto after = std::chrono::high_resolution_clock::now();
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count();
+        report.latencies.record(elapsed > overhead ? elapsed - overhead : 0);
+      }
+    } else {
+      auto before = std::chrono::high_resolution_clock::now();
+      for (size_t i = start; i < end; i++) operation(keys[i]);
+      total += std::chrono::high_resolution_clock::now() - before;
+      timedInBulk += end - start;
+    }
+  }
+
+  report.throughputNS = std::chrono::duration<double, std::nano>(total).count() / std::max<size_t>(timedInBulk, 1);
+  return report;
+}
+
+/**
+ * Returns the insertion and query reports for a table loaded to loadFactor,
+ * with keys drawn as in timeAbsolute.
+ */
+template <typename HT>
+std::tuple<LatencyReport, LatencyReport> timeLatency(double loadFactor, std::shared_ptr<HashFamily> family,
+                                                     size_t numActions) {
+  std::default_random_engine engine(kRandomSeed);
+  auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+  std::vector<int> inserts(numActions * loadFactor);
+  for (auto& key : inserts) key = gen(engine);
+  std::vector<int> queries(numActions);
+  for (auto& key : queries) key = gen(engine);
+
+  HT table(numActions + 2, family);
+  LatencyReport insertion = timeOperations(inserts, [&](int key) { table.insert(key); });
+  size_t found = 0;
+  LatencyReport query = timeOperations(queries, [&](int key) { found += table.contains(key); });
+  keepAlive(found);
+  return std::make_tuple(insertion, query);
+}
+
+inline void printLatency(const std::string& operation, const LatencyReport& report) {
+  const LatencyHistogram& latencies = report.latencies;
+  std::cout << "    " << std::left << std::setw(11) << operation + ":" << std::right << std::fixed << std::setw(8) << std::setprecision(2) << report.throughputNS
+            << " ns / op, p50 " << std::setw(6) << latencies.percentile(0.5)
+            << ", p99 " << std::setw(6) << latencies.percentile(0.99)
+            << ", p99.9 " << std::setw(6) << latencies.percentile(0.999)
+            << ", max " << std::setw(8) << latencies.max() << " ns" << std::endl;
+  ResultLog::current().record(operation, report.throughputNS, &latencies);
+}
+
+/**
+ * Print throughput and tail latencies, per hash family and load factor. The
+ * percentiles are of single operations, sampled as in timeOperations.
+ */
+template <typename HT>
+void doLatencyReports(std::initializer_list<std::shared_ptr<HashFamily>> factories, std::initializer_list<double> loadFactors,
+                      size_t numActions) {
+  for (auto family : factories) {
+    printFamily(family->name());
+    for (auto loadFactor : loadFactors) {
+      printLoadFactor(loadFactor);
+      auto reports = timeLatency<HT>(loadFactor, family, numActions);
+      printLatency("Insertion", std::get<0>(reports));
+      printLatency("Query", std::get<1>(reports));
+    }
+  }
+}
+
+/**
+ * Gather timing information for the batched operations. The keys are the
+ * same as in timeAbsolute, generated up front and handed to insert_many and
+ * contains_many in requests of kRequestSize keys. For comparison, a second
+ * table is given the same keys one at a time with insert and contains.
+ * Both are timed as a whole, and reported per key actually inserted or
+ * looked up.
+ *
+ * Returns a tuple: (insert time one at a time, batched insert time,
+ *                   query time one at a time, batched query time).
+ */
+static const size_t kRequestSize = 1000;
+
+template <typename HT>
+std::tuple<double, double, double, double> timeBatched(double loadFactor, std::shared_ptr<HashFamily> family,
+                                                       size_t numActions) {
+  std::default_random_engine engine(kRandomSeed);
+  auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+  std::vector<int> inserts(numActions * loadFactor);
+  for (auto& key : inserts) key = gen(engine);
+  std::vector<int> queries(numActions);
+  for (auto& key : queries) key = gen(engine);
+  std::unique_ptr<bool[]> found(new bool[queries.size()]);
+
+  auto nsPerKey = [](std::chrono::high_resolution_clock::duration time, size_t keys) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count() / (double) std::max<size_t>(keys, 1);
+  };
+
+  HT single(numActions + 2, family);
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int key : inserts) single.insert(key);
+  auto end = std::chrono::high_resolution_clock::now();
+  double insertSingle = nsPerKey(end - start, inserts.size());
+
+  start = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < queries.size(); i++) found[i] = single.contains(queries[i]);
+  end = std::chrono::high_resolution_clock::now();
+  double querySingle = nsPerKey(end - start, queries.size());
+
+  HT batched(numActions + 2, family);
+  start = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < inserts.size(); i += kRequestSize) {
+    batched.insert_many(&inserts[i], std::min(kRequestSize, inserts.size() - i));
+  }
+  end = std::chrono::high_resolution_clock::now();
+  double insertBatched = nsPerKey(end - start, inserts.size());
+
+  start = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < queries.size(); i += kRequestSize) {
+    batched.contains_many(&queries[i], std::min(kRequestSize, queries.size() - i), &found[i]);
+  }
+  end = std::chrono::high_resolution_clock::now();
+  double queryBatched = nsPerKey(end - start, queries.size());
+
+  return std::make_tuple(insertSingle, insertBatched, querySingle, queryBatched);
+}
+
+/**
+ * Print timing information for the batched operations against their one key
+ * at a time counterparts. The gain only shows once the table is larger than
+ * the last-level cache, so numActions should be in the millions.
+ */
+template <typename HT>
+void doBatchReports(std::initializer_list<std::shared_ptr<HashFamily>> factories, std::initializer_list<double> loadFactors,
+                    size_t numActions) {
+  for (auto family : factories) {
+    printFamily(family->name());
+    for (auto loadFactor : loadFactors) {
+      printLoadFactor(loadFactor);
+      auto times = timeBatched<HT>(loadFactor, family, numActions);
+      std::cout << "    Insertion: " << std::fixed << std::setw(8) << std::setprecision(2)
+                << std::get<0>(times) << " ns / op (one at a time), "
+                << std::setw(8) << std::get<1>(times) << " ns / op (batched)" << std::endl;
+      std::cout << "    Query:     " << std::fixed << std::setw(8) << std::setprecision(2)
+                << std::get<2>(times) << " ns / op (one at a time), "
+                << std::setw(8) << std::get<3>(times) << " ns / op (batched)" << std::endl;
+      ResultLog::current().record("Insertion (one at a time)", std::get<0>(times));
+      ResultLog::current().record("Insertion (batched)", std::get<1>(times));
+      ResultLog::current().record("Query (one at a time)", std::get<2>(times));
+      ResultLog::current().record("Query (batched)", std::get<3>(times));
+    }
+  }
+}
+
+/**
+ * Print timing information for starting up with a table of numKeys keys:
+ * rebuilding it key by key, against loading a snapshot of it, with and
+ * without verifying the checksum. Lookups are timed on the rebuilt table and
+ * on a freshly loaded one, whose pages are only faulted in as they are
+ * probed.
+ */
+template <typename HT>
+void doSnapshotReports(std::initializer_list<std::shared_ptr<HashFamily>> factories, std::initializer_list<double> loadFactors,
+                       size_t numKeys) {
+  typedef std::chrono::duration<double, std::milli> Millis;
+  typedef std::chrono::duration<double, std::nano> Nanos;
+  for (auto family : factories) {
+    printFamily(family->name());
+    for (auto loadFactor : loadFactors) {
+      printLoadFactor(loadFactor);
+      std::default_random_engine engine(kRandomSeed);
+      auto gen = std::uniform_int_distribution<int>(0, numKeys * kSpread);
+      std::vector<int> keys(numKeys * loadFactor);
+      for (auto& key : keys) key = gen(engine);
+      std::vector<int> queries(numKeys);
+      for (auto& key : queries) key = gen(engine);
+
+      auto timeQueries = [&](const HT& table) {
+        size_t found = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int key : queries) found += table.contains(key);
+        auto end = std::chrono::high_resolution_clock::now();
+        keepAlive(found);
+        return Nanos(end - start).count() / queries.size();
+      };
+
+      auto start = std::chrono::high_resolution_clock::now();
+      HT table(numKeys + 2, family);
+      for (int key : keys) table.insert(key);
+      auto end = std::chrono::high_resolution_clock::now();
+      double rebuild = Millis(end - start).count();
+      double queryRebuilt = timeQueries(table);
+      table.save(kSnapshotPath);
+
+      start = std::chrono::high_resolution_clock::now();
+      auto verified = HT::load(kSnapshotPath, true);
+      end = std::chrono::high_resolution_clock::now();
+      double loadVerified = Millis(end - start).count();
+      verified.reset();
+
+      start = std::chrono::high_resolution_clock::now();
+      auto loaded = HT::load(kSnapshotPath, false);
+      end = std::chrono::high_resolution_clock::now();
+      double load = Millis(end - start).count();
+      double queryLoaded = timeQueries(*loaded);
+      std::remove(kSnapshotPath);
+
+      std::cout << "    Rebuild:   " << std::fixed << std::setw(8) << std::setprecision(2) << rebuild << " ms" << std::endl;
+      std::cout << "    Load:      " << std::fixed << std::setw(8) << std::setprecision(2) << load << " ms, "
+                << std::setw(8) << loadVerified << " ms verified" << std::endl;
+      std::cout << "    Query:     " << std::fixed << std::setw(8) << std::setprecision(2) << queryRebuilt
+                << " ns / op (rebuilt), " << std::setw(8) << queryLoaded << " ns / op (loaded)" << std::endl;
+      ResultLog::current().record("Rebuild (per key)", rebuild * 1e6 / numKeys);
+      ResultLog::current().record("Load (per key)", load * 1e6 / numKeys);
+      ResultLog::current().record("Load verified (per key)", loadVerified * 1e6 / numKeys);
+      ResultLog::current().record("Query (rebuilt)", queryRebuilt);
+      ResultLog::current().record("Query (loaded)", queryLoaded);
+    }
+  }
+}
+
+/**
+ * Gather timing information for a table with keys of type Key, made from
+ * random integers by makeKey. The keys are made before the clock starts, so
+ * only the table operations are timed. Returns a pair: (average insert time,
+ * average query time).
+ */
+template <typename HT, typename Key>
+std::tuple<double, double> timeKeyed(double loadFactor, std::shared_ptr<BasicHashFamily<Key>> family,
+                                     size_t numActions) {
+  std::default_random_engine engine(kRandomSeed);
+  auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+
+  std::vector<Key> inserted, queried;
+  for (size_t i = 0; i < numActions * loadFactor; i++) inserted.push_back(makeKey<Key>(gen(engine)));
+  for (size_t i = 0; i < numActions; i++) queried.push_back(makeKey<Key>(gen(engine)));
+
+  HT table(numActions + 2, family);
+  auto start = std::chrono::high_resolution_clock::now();
+  for (const auto& key : inserted) table.insert(key);
+  auto middle = std::chrono::high_resolution_clock::now();
+  for (const auto& key : queried) table.contains(key);
+  auto end = std::chrono::high_resolution_clock::now();
+
+  std::chrono::duration<double, std::nano> insertion = middle - start;
+  std::chrono::duration<double, std::nano> query = end - middle;
+  return std::make_tuple(insertion.count() / std::max<size_t>(inserted.size(), 1),
+                         query.count() / queried.size());
+}
+
+template <typename HT, typename Key>
+void doKeyedReports(std::initializer_list<std::shared_ptr<BasicHashFamily<Key>>> factories, std::initializer_list<double> loadFactors) {
+  for (auto family : factories) {
+    printFamily(family->name());
+    for (auto loadFactor : loadFactors) {
+      printLoadFactor(loadFactor);
+      auto times = timeKeyed<HT, Key>(loadFactor, family, 100000);
+      std::cout << "    Insertion: " << std::fixed << std::setw(8) << std::setprecision(2)
+                << std::get<0>(times) << " ns / op" << std::endl;
+      std::cout << "    Query:     " << std::fixed << std::setw(8) << std::setprecision(2)
+                << std::get<1>(times) << " ns / op" << std::endl;
+      ResultLog::current().record("Insertion", std::get<0>(times));
+      ResultLog::current().record("Query", std::get<1>(times));
+    }
+  }
+}
+
+/**
+ * Presents a map as a set, so that the timing functions written for sets can
+ * sweep maps as well: insert maps a key to a value derived from it, and
+ * contains finds the key and reads its value, as a real lookup would.
+ */
+template <typename Map>
+class MapAsSet {
+public:
+  MapAsSet(size_t numBuckets, std::shared_ptr<HashFamily> family) : map(numBuckets, family) {}
+
+  void insert(int key) {
+    map.insert(key, valueFor(key));
+  }
+
+  bool contains(int key) const {
+    auto value = map.find(key);
+    return value != nullptr && *value == valueFor(key);
+  }
+
+  void remove(int key) {
+    map.remove(key);
+  }
+
+private:
+  static typename Map::value_type valueFor(int key) {
+    return typename Map::value_type(key) * 3 + 1;
+  }
+
+  Map map;
+};
+
+/**
+ * Gather throughput information for a table shared by several threads.
+ * The table is first filled to the given load factor by a single thread.
+ * Then every thread performs numActions operations at once: a fraction
+ * writeFraction of them remove or reinsert one of the keys filled in, and
+ * the rest look up keys chosen uniformly at random.
+ *
+ * Writers only touch keys that were filled in, so the tables never see more
+ * distinct keys than that. The whole run is timed with one clock, as timing
+ * each operation would swamp the contention being measured.
+ *
+ * Returns the total number of operations per second over all threads.
+ */
+template <typename HT>
+double timeThreads(double loadFactor, std::shared_ptr<HashFamily> family, size_t numActions,
+                   size_t numThreads, double writeFraction) {
+  std::default_random_engine engine(kRandomSeed);
+  auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+
+  HT table(numActions + 2, family);
+  std::vector<int> keys;
+  for (size_t i = 0; i < numActions * loadFactor; ++i) {
+    keys.push_back(gen(engine));
+    table.insert(keys.back());
+  }
+
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; t++) {
+    threads.emplace_back([&, t] {
+      std::default_random_engine engine(kRandomSeed + t);
+      auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+      auto pick = std::uniform_int_distribution<size_t>(0, keys.empty() ? 0 : keys.size() - 1);
+      auto coinFlip = std::bernoulli_distribution(writeFraction);
+      while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+      for (size_t i = 0; i < numActions; i++) {
+        if (!keys.empty() && coinFlip(engine)) {
+          int key = keys[pick(engine)];
+          if (i % 2) table.insert(key); else table.remove(key);
+        } else {
+          table.contains(gen(engine));
+        }
+      }
+    });
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto& thread : threads) thread.join();
+  auto end = std::chrono::high_resolution_clock::now();
+
+  double seconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+  return numThreads * numActions / seconds;
+}
+
+/**
+ * Print how throughput scales with the number of threads sharing a table.
+ */
+template <typename HT>
+void doThreadReports(std::initializer_list<std::shared_ptr<HashFamily>> factories, std::initializer_list<double> loadFactors,
+                     std::initializer_list<size_t> threadCounts, double writeFraction) {
+  std::cout << "(" << std::thread::hardware_concurrency() << " hardware threads, "
+            << std::fixed << std::setprecision(0) << 100 * writeFraction << "% writes)" << std::endl;
+  for (auto family : factories) {
+    printFamily(family->name());
+    for (auto loadFactor : loadFactors) {
+      printLoadFactor(loadFactor);
+      for (auto numThreads : threadCounts) {
+        double opsPerSecond = timeThreads<HT>(loadFactor, family, 100000, numThreads, writeFraction);
+        std::cout << "    " << std::setw(2) << numThreads << " threads: "
+                  << std::fixed << std::setw(8) << std::setprecision(2) << opsPerSecond / 1e6 << " Mops / s, "
+                  << std::setw(8) << opsPerSecond / 1e6 / numThreads << " Mops / s / thread" << std::endl;
+        ResultLog::current().record(std::to_string(numThreads) + " threads", 1e9 / opsPerSecond);
+      }
+    }
+  }
+}
+
+/**
+ * What timeWorkload measured: nanoseconds per insertion, per churn step (a
+ * removal and an insertion) and per query, the number of queries for
+ * stored keys and the number of queries the table answered with true.
+ */
+struct WorkloadTimes {
+  double insertionNS;
+  double churnNS;
+  double queryNS;
+  size_t hits;
+  size_t found;
+};
+
+/**
+ * Gather timing information for a workload (see Workloads.h). The table
+ * is filled with numActions * loadFactor of its keys. If the workload asks
+ * for churn, numActions steps follow, each replacing the key that has been
+ * in the table longest by a new one. Then numActions queries are made.
+ * The keys are generated up front, and each operation is timed as in
+ * timeGenerator, hardware counters included.
+ */
+template <typename HT>
+WorkloadTimes timeWorkload(const Workload& workload, double loadFactor, std::shared_ptr<HashFamily> family,
+                           size_t numActions) {
+  typedef std::chrono::high_resolution_clock Clock;
+  std::default_random_engine engine(kRandomSeed);
+
+  size_t numStored = numActions * loadFactor;
+  size_t numChurned = workload.churn && numStored > 0 ? numActions : 0;
+  std::vector<int> keys = workloadKeys(workload, numStored + numActions + numChurned, kSpread, engine);
+  std::vector<int> stored(keys.begin(), keys.begin() + numStored);
+  std::vector<int> misses(keys.begin() + numStored, keys.begin() + numStored + numActions);
+  std::vector<int> replacements(keys.begin() + numStored + numActions, keys.end());
+
+  HT table(numActions + 2, family); // The +2 term ensures that cuckoo hashing rounds the right way.
+  Clock::duration insertion = Clock::duration::zero();
+  Clock::duration churn = Clock::duration::zero();
+  Clock::duration query = Clock::duration::zero();
+  Clock::duration loop = Clock::duration::zero();
+  auto overhead = [&](size_t i) {
+    auto start = Clock::now();
+    keepAlive(keys[i]);
+    auto end = Clock::now();
+    loop += end - start;
+  };
+  PerfCounters::current().clearReadings();
+
+  countOperations("Insertion", numStored, [&](size_t i) {
+    auto start = Clock::now();
+    table.insert(stored[i]);
+    auto end = Clock::now();
+    insertion += end - start;
+  }, overhead);
+
+  countOperations("Churn", numChurned, [&](size_t i) {
+    int& oldest = stored[i % numStored];
+    auto start = Clock::now();
+    table.remove(oldest);
+    table.insert(replacements[i]);
+    auto end = Clock::now();
+    churn += end - start;
+    oldest = replacements[i];
+  }, overhead);
+
+  WorkloadTimes times;
+  std::vector<int> queries = workloadQueries(workload, stored, misses, numActions, engine, times.hits);
+  times.found = 0;
+  countOperations("Query", queries.size(), [&](size_t i) {
+    auto start = Clock::now();
+    bool found = table.contains(queries[i]);
+    auto end = Clock::now();
+    query += end - start;
+    times.found += found;
+  }, overhead);
+
+  typedef std::chrono::duration<double, std::nano> Nanos;
+  times.insertionNS = Nanos(insertion).count() / std::max<size_t>(numStored, 1);
+  times.churnNS = Nanos(churn).count() / std::max<size_t>(numChurned, 1);
+  times.queryNS = Nanos(query).count() / std::max<size_t>(queries.size(), 1);
+  return times;
+}
+
+/**
+ * Print timing information for every workload, per hash family and load
+ * factor. The workload's name is the variant of its results (see
+ * Results.h).
+ */
+template <typename HT>
+void doWorkloadReports(const std::vector<Workload>& workloads, std::initializer_list<std::shared_ptr<HashFamily>> factories,
+                       std::initializer_list<double> loadFactors, size_t numActions) {
+  for (auto family : factories) {
+    printFamily(family->name());
+    for (auto loadFactor : loadFactors) {
+      printLoadFactor(loadFactor);
+      for (const auto& workload : workloads) {
+        std::cout << "   " << workload.name << ":" << std::endl;
+        ResultLog::current().setVariant(workload.name);
+        auto times = timeWorkload<HT>(workload, loadFactor, family, numActions);
+        std::cout << "    Insertion: " << std::fixed << std::setw(8) << std::setprecision(2)
+                  << times.insertionNS << " ns / op" << std::endl;
+        ResultLog::current().record("Insertion", times.insertionNS);
+        if (workload.churn) {
+          std::cout << "    Churn:     " << std::fixed << std::setw(8) << std::setprecision(2)
+                    << times.churnNS << " ns / op (remove + insert)" << std::endl;
+          ResultLog::current().record("Churn", times.churnNS);
+        }
+        std::cout << "    Query:     " << std::fixed << std::setw(8) << std::setprecision(2)
+                  << times.queryNS << " ns / op" << std::endl;
+        ResultLog::current().record("Query", times.queryNS);
+        printCounters();
+      }
+    }
+  }
+}
+
+
 /**
  * Check correctness, using C++'s unordered_set type as an oracle
  */
@@ -171,4 +1003,447 @@ bool checkCorrectness(std::initializer_list<std::shared_ptr<HashFamily>> familie
   return true;
 }
 
+/**
+ * Check correctness of a growable table, starting it out with so few buckets
+ * that it has to grow many times over, with removals mixed into migration.
+ */
+template <typename HT>
+bool checkGrowth(std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  for (auto family: families) {
+    if (!checkCorrectness<HT>(4, family, 20000)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Check a table that is kept well filled while keys come and go: the table
+ * holds a window of consecutive keys, and every round removes the oldest
+ * ones and inserts as many new ones, then looks them all up. Under
+ * identityHash the new keys land in the empty buckets just ahead of the
+ * window while the removed ones leave their buckets behind it, so a table
+ * that doesn't clear its tombstones on its own runs out of empty buckets
+ * and its probes stop ending.
+ */
+template <typename HT>
+bool checkChurn(std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  const int buckets = 64;
+  const int numKeys = 48;
+  const int numRounds = 2000;
+  const int perRound = buckets - numKeys;
+  for (auto family : families) {
+    HT table(buckets, family);
+    for (int key = 0; key < numKeys; key++) table.insert(key);
+
+    int oldest = 0;
+    for (int round = 0; round < numRounds; round++) {
+      for (int key = oldest; key < oldest + perRound; key++) table.remove(key);
+      for (int key = oldest + numKeys; key < oldest + numKeys + perRound; key++) table.insert(key);
+      for (int key = oldest; key < oldest + perRound; key++) {
+        if (table.contains(key)) return false;
+      }
+      oldest += perRound;
+      for (int key = oldest; key < oldest + numKeys; key++) {
+        if (!table.contains(key)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Check the batched operations against the single-key ones: insert_many a
+ * batch of random keys, remove some again, and compare contains_many with
+ * contains over the whole key range.
+ */
+template <typename HT>
+bool checkBatchCorrectness(std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  const size_t numKeys = 5000;
+  for (auto family : families) {
+    std::default_random_engine engine(kRandomSeed);
+    auto gen = std::uniform_int_distribution<int>(0, numKeys * kSpread);
+
+    HT table(3 * numKeys, family);
+    std::unordered_set<int> reference;
+    std::vector<int> keys(numKeys);
+    for (auto& key : keys) key = gen(engine);
+    table.insert_many(keys.data(), keys.size());
+    reference.insert(keys.begin(), keys.end());
+    for (size_t i = 0; i < keys.size(); i += 3) {
+      table.remove(keys[i]);
+      reference.erase(keys[i]);
+    }
+
+    std::vector<int> queries(numKeys * kSpread + 1);
+    for (size_t i = 0; i < queries.size(); i++) queries[i] = i;
+    std::unique_ptr<bool[]> found(new bool[queries.size()]);
+    table.contains_many(queries.data(), queries.size(), found.get());
+    for (size_t i = 0; i < queries.size(); i++) {
+      if (found[i] != (reference.count(queries[i]) > 0) || found[i] != table.contains(queries[i])) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Check the workloads on a table: each must generate distinct keys, and the
+ * table must find exactly the queries that were for stored keys, including
+ * after churning through all of them.
+ */
+template <typename HT>
+bool checkWorkloads(const std::vector<Workload>& workloads, std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  const size_t numActions = 2000;
+  for (const auto& workload : workloads) {
+    std::default_random_engine engine(kRandomSeed);
+    auto keys = workloadKeys(workload, 3 * numActions, kSpread, engine);
+    if (std::unordered_set<int>(keys.begin(), keys.end()).size() != keys.size()) return false;
+
+    for (auto family : families) {
+      auto times = timeWorkload<HT>(workload, 0.4, family, numActions);
+      if (times.found != times.hits) return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Check correctness of a table with keys of type Key against an
+ * unordered_set, first one key at a time as checkCorrectness does, then
+ * through insert_many and contains_many.
+ */
+template <typename HT, typename Key>
+bool checkKeyedCorrectness(std::initializer_list<std::shared_ptr<BasicHashFamily<Key>>> families) {
+  const size_t numActions = 5000;
+  for (auto family : families) {
+    std::default_random_engine engine(kRandomSeed);
+    auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+    auto coinFlip = std::bernoulli_distribution();
+
+    HT table(3 * numActions, family);
+    std::unordered_set<Key> reference;
+    for (size_t i = 0; i < numActions; i++) {
+      Key key = makeKey<Key>(gen(engine));
+      if (coinFlip(engine)) {
+        reference.insert(key);
+        table.insert(key);
+      } else {
+        reference.erase(key);
+        table.remove(key);
+      }
+      if ((reference.count(key) > 0) != table.contains(key)) return false;
+    }
+
+    std::vector<Key> keys;
+    for (size_t i = 0; i < numActions; i++) keys.push_back(makeKey<Key>(gen(engine)));
+    table.insert_many(keys.data(), keys.size());
+    reference.insert(keys.begin(), keys.end());
+
+    std::vector<Key> queries;
+    for (size_t i = 0; i <= numActions * kSpread; i++) queries.push_back(makeKey<Key>(i));
+    std::unique_ptr<bool[]> found(new bool[queries.size()]);
+    table.contains_many(queries.data(), queries.size(), found.get());
+    for (size_t i = 0; i < queries.size(); i++) {
+      if (found[i] != (reference.count(queries[i]) > 0)) return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Check correctness of a map, using C++'s unordered_map type as an oracle.
+ * Keys are inserted, upserted with fresh values and removed at random, and
+ * after every action the map must agree with the oracle on the key's value.
+ */
+template <typename Map>
+bool checkMapCorrectness(size_t buckets, std::shared_ptr<HashFamily> family, size_t numActions) {
+  typedef typename Map::value_type Value;
+  std::default_random_engine engine(kRandomSeed);
+  auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+  auto action = std::uniform_int_distribution<int>(0, 2);
+
+  Map map(buckets, family);
+  std::unordered_map<int, Value> reference;
+  for (size_t i = 0; i < numActions; i++) {
+    int key = gen(engine);
+    Value value = Value(i);
+    switch (action(engine)) {
+    case 0:
+      if (map.insert(key, value) != reference.insert(std::make_pair(key, value)).second) return false;
+      break;
+    case 1:
+      map.upsert(key, value);
+      reference[key] = value;
+      break;
+    default:
+      map.remove(key);
+      reference.erase(key);
+    }
+    auto expected = reference.find(key);
+    const Value* found = map.find(key);
+    if (expected == reference.end() ? found != nullptr : found == nullptr || *found != expected->second) {
+      return false;
+    }
+    if (map.size() != reference.size()) return false;
+  }
+  return true;
+}
+
+/**
+ * Check a map as it fills up: keys go in until it throws std::length_error,
+ * which it must do before holding more keys than buckets, and every lookup,
+ * upsert and removal along the way, including those of absent keys, must
+ * still finish and be right.
+ */
+template <typename Map>
+bool checkFullMap(size_t buckets, std::shared_ptr<HashFamily> family) {
+  typedef typename Map::value_type Value;
+  const int absent = int(buckets) + 100;
+  Map map(buckets, family);
+  for (size_t key = 0; key <= buckets; key++) {
+    try {
+      map.insert(int(key), Value(key));
+    } catch (const std::length_error&) {
+      return map.size() + 1 >= buckets && !map.insert(0, Value(1)) && map.find(int(key)) == nullptr;
+    }
+    map.upsert(0, Value(0));
+    map.remove(absent);
+    if (map.size() != key + 1 || map.find(absent) != nullptr) return false;
+    for (size_t stored = 0; stored <= key; stored++) {
+      const Value* found = map.find(int(stored));
+      if (found == nullptr || *found != Value(stored)) return false;
+    }
+  }
+  return false; // never refused a key
+}
+
+template <typename Map>
+bool checkMapCorrectness(std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  for (auto family : families) {
+    if (!checkFullMap<Map>(4, family) ||
+        !checkMapCorrectness<Map>(12, family, 5) ||
+        !checkMapCorrectness<Map>(120, family, 50) ||
+        !checkMapCorrectness<Map>(12000, family, 5000)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Check that a map whose buckets mark emptiness with a key turns that key
+ * away: inserting or upserting it throws std::invalid_argument and leaves the
+ * map empty.
+ */
+template <typename Map>
+bool checkMapRejectsKey(int key, std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  for (auto family : families) {
+    Map map(12, family);
+    for (bool upsert : {false, true}) {
+      try {
+        if (upsert) map.upsert(key, typename Map::value_type());
+        else map.insert(key, typename Map::value_type());
+        return false;
+      } catch (const std::invalid_argument&) {
+      }
+    }
+    if (map.size() != 0 || map.find(key) != nullptr) return false;
+  }
+  return true;
+}
+
+/**
+ * Check snapshots of a table: fill it at random, save it, and check that the
+ * loaded copy holds the same keys, keeps working under further inserts and
+ * removes, and leaves the file untouched while doing so. A snapshot with a
+ * flipped byte must fail to load when verified.
+ */
+template <typename HT>
+bool checkSnapshot(std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  const size_t numActions = 5000;
+  for (auto family : families) {
+    std::default_random_engine engine(kRandomSeed);
+    auto gen = std::uniform_int_distribution<int>(0, numActions * kSpread);
+    auto coinFlip = std::bernoulli_distribution();
+
+    HT table(3 * numActions, family);
+    std::unordered_set<int> reference;
+    for (size_t i = 0; i < numActions; i++) {
+      int key = gen(engine);
+      if (coinFlip(engine)) {
+        table.insert(key);
+        reference.insert(key);
+      } else {
+        table.remove(key);
+        reference.erase(key);
+      }
+    }
+    table.save(kSnapshotPath);
+
+    auto matches = [&](const HT& candidate, const std::unordered_set<int>& expected) {
+      if (candidate.size() != expected.size()) return false;
+      for (size_t key = 0; key <= numActions * kSpread; key++) {
+        if (candidate.contains(key) != (expected.count(key) > 0)) return false;
+      }
+      return true;
+    };
+
+    auto loaded = HT::load(kSnapshotPath);
+    if (!matches(*loaded, reference)) return false;
+
+    std::unordered_set<int> changed = reference;
+    for (size_t i = 0; i < numActions; i++) {
+      int key = gen(engine);
+      if (coinFlip(engine)) {
+        loaded->insert(key);
+        changed.insert(key);
+      } else {
+        loaded->remove(key);
+        changed.erase(key);
+      }
+    }
+    if (!matches(*loaded, changed)) return false;
+    if (!matches(*HT::load(kSnapshotPath), reference)) return false; // the file is as saved
+
+    {
+      std::fstream file(kSnapshotPath, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekg(-1, std::ios::end);
+      char last = char(file.get());
+      file.seekp(-1, std::ios::end);
+      file.put(char(last ^ 0x5A));
+    }
+    bool rejected = false;
+    try {
+      HT::load(kSnapshotPath);
+    } catch (const std::runtime_error&) {
+      rejected = true;
+    }
+    std::remove(kSnapshotPath);
+    if (!rejected) return false;
+  }
+  return true;
+}
+
+/**
+ * Check that hash functions can be replayed. Families made with the same
+ * seed must hand out the same functions in the same order and families with
+ * different seeds different ones, and what get(engine) returns must depend
+ * on engine alone, even while other threads draw from the same family.
+ */
+typedef std::shared_ptr<HashFamily> (*SeededHashFamily)(uint64_t seed);
+
+inline bool checkSeeding(std::initializer_list<SeededHashFamily> makers) {
+  auto same = [](const HashFunction& f, const HashFunction& g) {
+    for (int key = -1000; key < 1000; key++) {
+      if (f(key) != g(key)) return false;
+    }
+    return true;
+  };
+
+  for (auto make : makers) {
+    auto family = make(kRandomSeed), twin = make(kRandomSeed), other = make(kRandomSeed + 1);
+    for (int i = 0; i < 3; i++) {
+      HashFunction h = family->get();
+      if (!same(h, twin->get()) || same(h, other->get())) return false;
+    }
+
+    const int numThreads = 4;
+    std::vector<HashFunction> expected;
+    for (int t = 0; t < numThreads; t++) {
+      HashEngine engine(t);
+      expected.push_back(family->get(engine));
+    }
+    std::atomic<bool> correct(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      threads.emplace_back([&, t] {
+        for (int round = 0; round < 20; round++) {
+          family->get(); // draw from the shared generator in between
+          HashEngine engine(t);
+          if (!same(family->get(engine), expected[t])) correct = false;
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    if (!correct) return false;
+  }
+  return true;
+}
+
+/**
+ * Check correctness of a table shared by several threads. Each thread inserts
+ * its own keys, removes every other one again and looks them all up, while
+ * the other threads do the same next to it.
+ */
+template <typename HT>
+bool checkConcurrentCorrectness(std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  const int numThreads = 4;
+  const int keysPerThread = 5000;
+  for (auto family : families) {
+    HT table(4 * numThreads * keysPerThread, family); // low enough a load for cuckoo hashing
+    std::atomic<bool> correct(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      threads.emplace_back([&, t] {
+        for (int i = t; i < numThreads * keysPerThread; i += numThreads) table.insert(i);
+        for (int i = t; i < numThreads * keysPerThread; i += 2 * numThreads) table.remove(i);
+        for (int i = t; i < numThreads * keysPerThread; i += numThreads) {
+          if (table.contains(i) != (i % (2 * numThreads) != t)) correct = false;
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    if (!correct) return false;
+  }
+  return true;
+}
+
+/**
+ * Check a table shared by several threads under churn. Each thread inserts a
+ * fresh range of keys every round, looks them up and removes them again, so
+ * that over all rounds many times more distinct keys pass through the table
+ * than it has buckets. All threads also insert the same few shared keys
+ * every round; at the end, removing each of those once must leave it absent,
+ * which it wouldn't if some thread had stored a second copy.
+ */
+template <typename HT>
+bool checkConcurrentChurn(std::initializer_list<std::shared_ptr<HashFamily>> families) {
+  const int numThreads = 4;
+  const int keysPerRound = 500;
+  const int numRounds = 20;
+  const int numShared = 64;
+  const int firstShared = numThreads * numRounds * keysPerRound; // past every thread's keys
+  for (auto family : families) {
+    HT table(4 * numThreads * keysPerRound, family); // low enough a load for cuckoo hashing
+    std::atomic<bool> correct(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+      threads.emplace_back([&, t] {
+        for (int round = 0; round < numRounds; round++) {
+          int first = (round * numThreads + t) * keysPerRound;
+          for (int key = first; key < first + keysPerRound; key++) table.insert(key);
+          for (int key = firstShared; key < firstShared + numShared; key++) table.insert(key);
+          for (int key = first; key < first + keysPerRound; key++) {
+            if (!table.contains(key)) correct = false;
+          }
+          for (int key = first; key < first + keysPerRound; key++) table.remove(key);
+          for (int key = first; key < first + keysPerRound; key++) {
+            if (table.contains(key)) correct = false;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    for (int key = firstShared; key < firstShared + numShared; key++) {
+      if (!table.contains(key)) correct = false;
+      table.remove(key);
+      if (table.contains(key)) correct = false;
+    }
+    if (!correct) return false;
+  }
+  return true;
+}
+
 #endif
@@ -0,0 +1,124 @@
+#include "Workloads.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+/* "50% hits", "all hits" or "no hits". */
+static std::string describeHits(double hitRatio) {
+  if (hitRatio >= 1) return "all hits";
+  if (hitRatio <= 0) return "no hits";
+  std::ostringstream text;
+  text << 100 * hitRatio << "% hits";
+  return text.str();
+}
+
+static Workload makeWorkload(const std::string& name, Workload::Keys keys, int stride, double zipfExponent,
+                             double hitRatio, bool churn) {
+  Workload workload;
+  workload.name = name + ", " + describeHits(hitRatio);
+  workload.keys = keys;
+  workload.stride = stride;
+  workload.zipfExponent = zipfExponent;
+  workload.hitRatio = hitRatio;
+  workload.churn = churn;
+  return workload;
+}
+
+Workload uniformWorkload(double hitRatio) {
+  return makeWorkload("Uniform", Workload::Keys::Random, 1, 0, hitRatio, false);
+}
+
+Workload zipfianWorkload(double zipfExponent, double hitRatio) {
+  std::ostringstream name;
+  name << "Zipfian (z = " << zipfExponent << ")";
+  return makeWorkload(name.str(), Workload::Keys::Random, 1, zipfExponent, hitRatio, false);
+}
+
+Workload sequentialWorkload(double hitRatio) {
+  return makeWorkload("Sequential", Workload::Keys::Sequential, 1, 0, hitRatio, false);
+}
+
+Workload stridedWorkload(int stride, double hitRatio) {
+  if (stride <= 0) throw std::invalid_argument("A stride must be positive.");
+  return makeWorkload("Strided by " + std::to_string(stride), Workload::Keys::Strided, stride, 0, hitRatio, false);
+}
+
+Workload churnWorkload(double hitRatio) {
+  return makeWorkload("Churn", Workload::Keys::Random, 1, 0, hitRatio, true);
+}
+
+std::vector<Workload> standardWorkloads() {
+  return {
+    uniformWorkload(),
+    uniformWorkload(1.0),
+    uniformWorkload(0.0),
+    zipfianWorkload(0.99),
+    sequentialWorkload(),
+    stridedWorkload(64),
+    churnWorkload()
+  };
+}
+
+std::vector<int> workloadKeys(const Workload& workload, size_t count, size_t spread,
+                              std::default_random_engine& engine) {
+  std::vector<int> keys(count);
+  switch (workload.keys) {
+  case Workload::Keys::Sequential:
+    std::iota(keys.begin(), keys.end(), 0);
+    break;
+
+  case Workload::Keys::Strided:
+    for (size_t i = 0; i < count; i++) keys[i] = int(i * workload.stride);
+    break;
+
+  case Workload::Keys::Random: {
+    // The first count steps of a Fisher-Yates shuffle of the whole range.
+    std::vector<int> range(count * spread + 1);
+    std::iota(range.begin(), range.end(), 0);
+    for (size_t i = 0; i < count; i++) {
+      std::uniform_int_distribution<size_t> pick(i, range.size() - 1);
+      std::swap(range[i], range[pick(engine)]);
+      keys[i] = range[i];
+    }
+    break;
+  }
+  }
+  return keys;
+}
+
+std::vector<int> workloadQueries(const Workload& workload, const std::vector<int>& stored,
+                                 const std::vector<int>& misses, size_t numQueries,
+                                 std::default_random_engine& engine, size_t& hits) {
+  std::vector<int> queries(numQueries);
+  hits = 0;
+  if (stored.empty() && misses.empty()) return queries;
+
+  auto popularity = zipfian(std::max<size_t>(stored.size(), 1), workload.zipfExponent, engine);
+  std::uniform_int_distribution<size_t> anyMiss(0, std::max<size_t>(misses.size(), 1) - 1);
+  std::bernoulli_distribution isHit(workload.hitRatio);
+  for (auto& query : queries) {
+    if (misses.empty() || (!stored.empty() && isHit(engine))) {
+      query = stored[popularity(engine)];
+      hits++;
+    } else {
+      query = misses[anyMiss(engine)];
+    }
+  }
+  return queries;
+}
+
+std::discrete_distribution<size_t> zipfian(size_t count, double z, std::default_random_engine& engine) {
+  std::vector<double> weights(count);
+  for (size_t i = 0; i < count; i++) {
+    weights[i] = 1 / std::pow(i + 1, z);
+  }
+
+  /* Permute the elements. This makes it unlikely that the elements that will
+   * be looked up will be anywhere near one another.
+   */
+  std::shuffle(weights.begin(), weights.end(), engine);
+  return std::discrete_distribution<size_t>(weights.begin(), weights.end());
+}
@@ -0,0 +1,69 @@
+#ifndef Workloads_Included
+#define Workloads_Included
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Workloads for timing the tables on keys other than uniformly random ones.
+ * A workload says what the keys look like, which stored keys the queries
+ * favour, how many queries hit, and whether the table sees a steady churn
+ * of removals and insertions before it is queried:
+ *
+ *    Random      distinct keys drawn uniformly, as in timeAbsolute
+ *    Sequential  0, 1, 2, ...: every hash family copes, identityHash maps
+ *                them onto one long run of buckets
+ *    Strided     0, s, 2s, ...: identityHash uses only the buckets that are
+ *                multiples of gcd(s, number of buckets)
+ *
+ * Queries for stored keys pick them uniformly or, given a Zipf exponent z,
+ * with the i-th most popular key asked for in proportion to 1 / i^z. The
+ * other queries are for keys of the same shape that were never stored.
+ */
+struct Workload {
+  enum class Keys { Random, Sequential, Strided };
+
+  std::string name;
+  Keys keys;
+  int stride;          // for Keys::Strided
+  double zipfExponent; // 0 for uniform popularity
+  double hitRatio;     // the fraction of queries for stored keys
+  bool churn;          // replace every stored key before the queries
+};
+
+Workload uniformWorkload(double hitRatio = 0.5);
+Workload zipfianWorkload(double zipfExponent, double hitRatio = 0.5);
+Workload sequentialWorkload(double hitRatio = 0.5);
+Workload stridedWorkload(int stride, double hitRatio = 0.5);
+Workload churnWorkload(double hitRatio = 0.5);
+
+/* The workloads run-tests reports on. */
+std::vector<Workload> standardWorkloads();
+
+/**
+ * Returns count distinct keys of the workload's shape, in the order in
+ * which they should be inserted. Random keys come from [0, count * spread].
+ */
+std::vector<int> workloadKeys(const Workload& workload, size_t count, size_t spread,
+                              std::default_random_engine& engine);
+
+/**
+ * Returns numQueries queries: stored keys, with the workload's popularity,
+ * for a fraction hitRatio of them and keys from misses for the rest. hits
+ * is set to the number of queries for stored keys.
+ */
+std::vector<int> workloadQueries(const Workload& workload, const std::vector<int>& stored,
+                                 const std::vector<int>& misses, size_t numQueries,
+                                 std::default_random_engine& engine, size_t& hits);
+
+/**
+ * Returns a random number generator for the indices 0, ..., count - 1 that
+ * follows a Zipfian distribution with exponent z, as pset4's zipfian does:
+ * the ranks are shuffled, so that popular indices are not next to each
+ * other. When z is 0, the distribution is uniform.
+ */
+std::discrete_distribution<size_t> zipfian(size_t count, double z, std::default_random_engine& engine);
+
+#endif